@@ -1,866 +1,7617 @@
-#include <windows.h>
-#include <tlhelp32.h>
-#include <shlobj.h>
-#include <shellapi.h>
-#include <string>
-#include <vector>
-#include <filesystem>
-#include <thread>
-#include <chrono>
-#include <algorithm>
-#include <atlbase.h>
-#include <exdisp.h>
-#include <shobjidl.h>
-#include <commctrl.h>
-#include <set>
-#undef ShellExecute
-#pragma comment(lib, "user32.lib")
-#pragma comment(lib, "gdi32.lib")
-#pragma comment(lib, "shell32.lib")
-#pragma comment(lib, "ole32.lib")
-#pragma comment(lib, "oleaut32.lib")
-#pragma comment(lib, "advapi32.lib")
-#pragma comment(lib, "comctl32.lib")
-
-static const UINT WM_APP_PROGRESS = WM_APP + 1;
-
-static void AppendLog(HWND hEdit, const std::wstring& line) {
-    std::wstring withNL = line + L"\r\n";
-    SendMessageW(hEdit, EM_SETSEL, (WPARAM)-1, (LPARAM)-1);
-    SendMessageW(hEdit, EM_REPLACESEL, FALSE, (LPARAM)withNL.c_str());
-}
-
-static void PostLogAndProgress(HWND hwnd, HWND hEdit, const std::wstring& line, int progress) {
-    PostMessageW(hwnd, WM_APP_PROGRESS, (WPARAM)progress, 0);
-    AppendLog(hEdit, line);
-}
-
-static std::wstring Trim(const std::wstring& s) {
-    size_t start = s.find_first_not_of(L" \t\r\n");
-    size_t end = s.find_last_not_of(L" \t\r\n");
-    if (start == std::wstring::npos) return L"";
-    return s.substr(start, end - start + 1);
-}
-
-static bool CaseInsensitiveEquals(const std::wstring& a, const std::wstring& b) {
-    if (a.size() != b.size()) return false;
-    for (size_t i = 0; i < a.size(); ++i) {
-        if (towlower(a[i]) != towlower(b[i])) return false;
-    }
-    return true;
-}
-
-static bool TerminateAndWait(HANDLE hProcess, DWORD timeoutMs) {
-    if (!hProcess) return false;
-    if (!TerminateProcess(hProcess, 1)) {
-        CloseHandle(hProcess);
-        return false;
-    }
-    DWORD wait = WaitForSingleObject(hProcess, timeoutMs);
-    CloseHandle(hProcess);
-    return wait == WAIT_OBJECT_0;
-}
-
-static bool ContainsCaseInsensitive(const std::wstring& hay, const std::wstring& needle) {
-    std::wstring H = hay, N = needle;
-    std::transform(H.begin(), H.end(), H.begin(), ::towlower);
-    std::transform(N.begin(), N.end(), N.begin(), ::towlower);
-    return H.find(N) != std::wstring::npos;
-}
-
-static bool IsProcessElevated() {
-    HANDLE hToken = nullptr;
-    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken)) return false;
-    TOKEN_ELEVATION elevation{};
-    DWORD size = 0;
-    bool elevated = false;
-    if (GetTokenInformation(hToken, TokenElevation, &elevation, sizeof(elevation), &size)) {
-        elevated = elevation.TokenIsElevated != 0;
-    }
-    CloseHandle(hToken);
-    return elevated;
-}
-
-static bool RelaunchElevated(HWND owner) {
-    wchar_t path[MAX_PATH];
-    if (!GetModuleFileNameW(nullptr, path, MAX_PATH)) return false;
-    SHELLEXECUTEINFOW sei{};
-    sei.cbSize = sizeof(sei);
-    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
-    sei.hwnd = owner;
-    sei.lpVerb = L"runas";
-    sei.lpFile = path;
-    sei.nShow = SW_SHOWNORMAL;
-    if (!ShellExecuteExW(&sei)) return false;
-    return true;
-}
-
-static DWORD RunProcessWait(const std::wstring& app, const std::wstring& args, bool hidden = true) {
-    SHELLEXECUTEINFOW sei{};
-    sei.cbSize = sizeof(sei);
-    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
-    sei.lpFile = app.c_str();
-    sei.lpParameters = args.empty() ? nullptr : args.c_str();
-    sei.nShow = hidden ? SW_HIDE : SW_SHOWNORMAL;
-    if (!ShellExecuteExW(&sei) || !sei.hProcess) return (DWORD)-1;
-    WaitForSingleObject(sei.hProcess, INFINITE);
-    DWORD code = 0;
-    GetExitCodeProcess(sei.hProcess, &code);
-    CloseHandle(sei.hProcess);
-    return code;
-}
-
-static std::wstring GetEnv(const wchar_t* name) {
-    DWORD len = GetEnvironmentVariableW(name, nullptr, 0);
-    if (len == 0) return L"";
-    std::wstring v(len, L'\0');
-    GetEnvironmentVariableW(name, &v[0], len);
-    if (!v.empty() && v.back() == L'\0') v.pop_back();
-    return v;
-}
-
-static std::wstring GetKnownFolder(REFKNOWNFOLDERID id) {
-    PWSTR p = nullptr;
-    std::wstring result;
-    if (SUCCEEDED(SHGetKnownFolderPath(id, 0, nullptr, &p))) {
-        result = p;
-        CoTaskMemFree(p);
-    }
-    return result;
-}
-
-static std::wstring GetDownloadsPath() {
-    std::wstring dl = GetKnownFolder(FOLDERID_Downloads);
-    if (!dl.empty()) return dl;
-    std::wstring user = GetEnv(L"USERPROFILE");
-    if (!user.empty()) {
-        std::filesystem::path p = std::filesystem::path(user) / L"Downloads";
-        return p.wstring();
-    }
-    return L"";
-}
-
-static std::wstring GetLocalTemp() {
-    std::wstring temp = GetEnv(L"LOCALAPPDATA");
-    if (!temp.empty()) {
-        std::filesystem::path p = std::filesystem::path(temp) / L"Temp";
-        return p.wstring();
-    }
-    temp = GetEnv(L"TEMP");
-    if (!temp.empty()) return temp;
-    return L"C:\\Windows\\Temp";
-}
-
-static std::filesystem::path GetBackupRoot() {
-    std::filesystem::path root = std::filesystem::path(GetLocalTemp()) / L"ZenithFixerBackup";
-    std::error_code ec;
-    std::filesystem::create_directories(root, ec);
-    return root;
-}
-
-static bool DownloadWithInvokeWebRequest(const std::wstring& url, const std::wstring& dest, HWND log = nullptr) {
-    std::wstring psCmd =
-        L"-NoProfile -Command \"$u='" + url + L"'; $o='" + dest +
-        L"'; Invoke-WebRequest -Uri $u -OutFile $o -UseBasicParsing\"";
-    if (log) AppendLog(log, L" PowerShell: " + psCmd);
-    DWORD code = RunProcessWait(L"powershell.exe", psCmd, true);
-    return code == 0;
-}
-
-static void CloseRobloxBrowserTabs(HWND log) {
-    AppendLog(log, L"Attempting to close Roblox browser tabs/windows...");
-    std::wstring psCmd =
-        L"-NoProfile -WindowStyle Hidden -Command \"$p=Get-Process; "
-        L"$w=$p | Where-Object { $_.MainWindowTitle -like '*Roblox*' }; "
-        L"$w | ForEach-Object { $_.CloseMainWindow() | Out-Null }\"";
-    RunProcessWait(L"powershell.exe", psCmd, true);
-}
-
-static bool Cleanup(HWND log) {
-    AppendLog(log, L"DISM /Online /Cleanup-Image /RestoreHealth, this may take long depending on your pc...");
-    DWORD code = RunProcessWait(L"powershell.exe", L"-NoProfile -Command DISM /Online /Cleanup-Image /RestoreHealth");
-    AppendLog(log, L" DISM completed with exit code " + std::to_wstring(code));
-    return code == 0 || code == 1;
-}
-
-static bool Synctime(HWND log) {
-    AppendLog(log, L"Syncing time and date settings (w32tm /resync /rediscover)...");
-    DWORD code = RunProcessWait(L"powershell.exe", L"-NoProfile -Command w32tm /resync /rediscover");
-    AppendLog(log, L" w32tm completed with exit code " + std::to_wstring(code));
-    return code == 0 || code == 1;
-}
-
-static bool RunSFC(HWND log) {
-    AppendLog(log, L"Running system file check, this may take long depending on your pc (sfc /scannow)...");
-    DWORD code = RunProcessWait(L"powershell.exe", L"-NoProfile -Command sfc /scannow");
-    AppendLog(log, L" SFC completed with exit code " + std::to_wstring(code));
-    return code == 0 || code == 1;
-}
-
-static bool EnableDEP(HWND log) {
-    AppendLog(log, L"Enabling system DEP via Set-ProcessMitigation...");
-    DWORD code = RunProcessWait(L"powershell.exe",
-                                L"-NoProfile -Command Set-ProcessMitigation -System -Enable Dep");
-    AppendLog(log, L" DEP command exit code " + std::to_wstring(code));
-    return code == 0;
-}
-
-static bool InstallOrRepairVCRedist(HWND log) {
-    AppendLog(log, L"Downloading VC++ Redistributable (x64), this may take long depending on your pc...");
-    std::wstring temp = GetLocalTemp();
-    std::filesystem::path dest = std::filesystem::path(temp) / L"vc_redist.x64.exe";
-    if (!DownloadWithInvokeWebRequest(L"https://aka.ms/vs/17/release/vc_redist.x64.exe", dest.wstring(), log)) {
-        AppendLog(log, L" Failed to download VC++ redistributable.");
-        return false;
-    }
-    AppendLog(log, L" Running VC++ redistributable installer, this may take long depending on your pc (silent)...");
-    DWORD code = RunProcessWait(dest.wstring(), L"/install /quiet /norestart", true);
-    AppendLog(log, L" VC++ installer exit code " + std::to_wstring(code));
-    return code == 0;
-}
-
-static bool RunWebview2Fixer(HWND log) {
-    AppendLog(log, L"Webview2 Fixer, this may take long depending on your pc...");
-    std::wstring temp = GetLocalTemp();
-    std::filesystem::path dest = std::filesystem::path(temp) / L"zenith_webview_fix.bat";
-    if (!DownloadWithInvokeWebRequest(L"https://cdn.discordapp.com/attachments/1411411203624013976/1425261893613785118/zenith_webview_fix.bat?ex=68e6f213&is=68e5a093&hm=83f200541ca7bd7a8b085d67eae1091b33f524659452070dbfe302a31860f55d&", dest.wstring(), log)) {
-        AppendLog(log, L" Failed to download Webview2 Fixer");
-        return false;
-    }
-    AppendLog(log, L" Running Webview2 Fixer, this may take long depending on your pc...");
-    DWORD code = RunProcessWait(dest.wstring(), L"/quiet /norestart", true);
-    AppendLog(log, L" Webview2 Fixer exit code " + std::to_wstring(code));
-    return code == 0;
-}
-
-static std::wstring GetDesktopPath() {
-    std::wstring path = GetKnownFolder(FOLDERID_Desktop);
-    if (!path.empty()) return path;
-    std::wstring user = GetEnv(L"USERPROFILE");
-    if (!user.empty()) {
-        std::filesystem::path p = std::filesystem::path(user) / L"Desktop";
-        return p.wstring();
-    }
-    return L"";
-}
-
-static std::wstring GetOneDrivePath() {
-    std::wstring od = GetEnv(L"OneDrive");
-    if (!od.empty()) return od;
-    std::wstring user = GetEnv(L"USERPROFILE");
-    if (!user.empty()) {
-        std::filesystem::path p = std::filesystem::path(user) / L"OneDrive";
-        if (std::filesystem::exists(p)) return p.wstring();
-    }
-    return L"";
-}
-
-static void AddZenithDefenderExclusions(HWND log) {
-    AppendLog(log, L"Scanning Downloads, Desktop, and OneDrive for targets to add Defender exclusions...");
-
-    std::vector<std::wstring> roots;
-    std::wstring downloads = GetDownloadsPath();
-    if (!downloads.empty()) roots.push_back(downloads);
-    std::wstring desktop = GetDesktopPath();
-    if (!desktop.empty()) roots.push_back(desktop);
-    std::wstring onedrive = GetOneDrivePath();
-    if (!onedrive.empty()) roots.push_back(onedrive);
-
-    if (roots.empty()) {
-        AppendLog(log, L" Unable to resolve any of Downloads, Desktop, or OneDrive.");
-        return;
-    }
-
-    std::vector<std::wstring> targets = { L"Zenith.exe", L"luau-lsp", L"Zenith-Module.dll" };
-    std::set<std::wstring> addedExclusions;
-
-    for (const auto& root : roots) {
-        try {
-            std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied);
-            std::filesystem::recursive_directory_iterator end;
-            for (; it != end; ++it) {
-                std::error_code ec;
-                const auto& entry = *it;
-                std::wstring name = entry.path().filename().wstring();
-                std::wstring lname = name;
-                std::transform(lname.begin(), lname.end(), lname.begin(), ::towlower);
-
-                bool match = false;
-                for (const auto& t : targets) {
-                    std::wstring lt = t;
-                    std::transform(lt.begin(), lt.end(), lt.begin(), ::towlower);
-                    if (lt == L"luau-lsp") {
-                        if (lname == lt || ContainsCaseInsensitive(name, lt)) { match = true; break; }
-                    } else {
-                        if (CaseInsensitiveEquals(name, t) || ContainsCaseInsensitive(name, t)) { match = true; break; }
-                    }
-                }
-                if (!match) continue;
-
-                std::wstring foundPath = entry.path().wstring();
-
-                std::wstring exclusionPath = foundPath;
-                if (addedExclusions.find(exclusionPath) == addedExclusions.end()) {
-                    AppendLog(log, L" Adding Defender exclusion: " + exclusionPath);
-                    std::wstring cmd = L"-NoProfile -Command Add-MpPreference -ExclusionPath '" + exclusionPath + L"'";
-                    RunProcessWait(L"powershell.exe", cmd, true);
-                    addedExclusions.insert(exclusionPath);
-                }
-
-                std::filesystem::path parent = entry.path().parent_path();
-                if (!parent.empty()) {
-                    std::wstring parentPath = parent.wstring();
-                    if (addedExclusions.find(parentPath) == addedExclusions.end()) {
-                        AppendLog(log, L" Adding Defender exclusion for parent folder: " + parentPath);
-                        std::wstring cmdFolder = L"-NoProfile -Command Add-MpPreference -ExclusionPath '" + parentPath + L"'";
-                        RunProcessWait(L"powershell.exe", cmdFolder, true);
-                        addedExclusions.insert(parentPath);
-                    }
-                }
-
-                if (entry.is_directory(ec)) {
-                    it.disable_recursion_pending();
-                }
-            }
-        } catch (const std::exception& ex) {
-            std::wstring what;
-            try {
-                std::string s = ex.what();
-                what.assign(s.begin(), s.end());
-            } catch (...) {
-                what = L"exception";
-            }
-            AppendLog(log, L" Error scanning: " + std::wstring(what.begin(), what.end()));
-        } catch (...) {
-            AppendLog(log, L" Unknown error scanning: " + root);
-        }
-    }
-
-    if (addedExclusions.empty()) {
-        AppendLog(log, L"No matching files or folders found to add exclusions for.");
-    } else {
-        AppendLog(log, L"Finished adding Defender exclusions.");
-    }
-}
-
-static void BackupRobloxData(HWND log) {
-    std::wstring local = GetEnv(L"LOCALAPPDATA");
-    if (local.empty()) local = GetKnownFolder(FOLDERID_LocalAppData);
-    if (local.empty()) {
-        AppendLog(log, L" Unable to resolve LocalAppData for backup.");
-        return;
-    }
-    std::filesystem::path roblox = std::filesystem::path(local) / L"Roblox";
-    std::filesystem::path srcLS = roblox / L"LocalStorage";
-    std::filesystem::path srcRS = roblox / L"rbx-storage";
-    std::filesystem::path backupRoot = GetBackupRoot();
-    std::filesystem::path dstLS = backupRoot / L"LocalStorage";
-    std::filesystem::path dstRS = backupRoot / L"rbx-storage";
-    std::error_code ec;
-    if (std::filesystem::exists(srcLS)) {
-        AppendLog(log, L"Backing up LocalStorage...");
-        std::filesystem::create_directories(dstLS, ec);
-        std::filesystem::copy(srcLS, dstLS, std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
-    }
-    if (std::filesystem::exists(srcRS)) {
-        AppendLog(log, L"Backing up rbx-storage...");
-        std::filesystem::create_directories(dstRS, ec);
-        std::filesystem::copy(srcRS, dstRS, std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
-    }
-}
-
-static void DeleteAppDataDirs(HWND log) {
-    AppendLog(log, L"Deleting LocalAppData folders: Roblox, fishstrap, bloxstrap...");
-    std::wstring local = GetEnv(L"LOCALAPPDATA");
-    if (local.empty()) local = GetKnownFolder(FOLDERID_LocalAppData);
-    if (local.empty()) {
-        AppendLog(log, L" Unable to resolve LocalAppData.");
-        return;
-    }
-    std::vector<std::wstring> targets = {
-        (std::filesystem::path(local) / L"Roblox").wstring(),
-        (std::filesystem::path(local) / L"fishstrap").wstring(),
-        (std::filesystem::path(local) / L"bloxstrap").wstring()
-    };
-    for (const auto& t : targets) {
-        try {
-            if (std::filesystem::exists(t)) {
-                AppendLog(log, L" Removing: " + t);
-                std::filesystem::remove_all(t);
-            } else {
-                AppendLog(log, L" Not found: " + t);
-            }
-        } catch (...) {
-            AppendLog(log, L" Failed to remove: " + t);
-        }
-    }
-}
-
-static void RestoreRobloxData(HWND log) {
-    std::wstring local = GetEnv(L"LOCALAPPDATA");
-    if (local.empty()) local = GetKnownFolder(FOLDERID_LocalAppData);
-    if (local.empty()) {
-        AppendLog(log, L" Unable to resolve LocalAppData for restore.");
-        return;
-    }
-    std::filesystem::path roblox = std::filesystem::path(local) / L"Roblox";
-    std::filesystem::path backupRoot = GetBackupRoot();
-    std::filesystem::path srcLS = backupRoot / L"LocalStorage";
-    std::filesystem::path srcRS = backupRoot / L"rbx-storage";
-    std::filesystem::path dstLS = roblox / L"LocalStorage";
-    std::filesystem::path dstRS = roblox / L"rbx-storage";
-    std::error_code ec;
-    std::filesystem::create_directories(roblox, ec);
-    if (std::filesystem::exists(srcLS)) {
-        AppendLog(log, L"Restoring LocalStorage...");
-        std::filesystem::create_directories(dstLS, ec);
-        std::filesystem::copy(srcLS, dstLS, std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
-    }
-    if (std::filesystem::exists(srcRS)) {
-        AppendLog(log, L"Restoring rbx-storage...");
-        std::filesystem::create_directories(dstRS, ec);
-        std::filesystem::copy(srcRS, dstRS, std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
-    }
-}
-
-static void KillRobloxProcesses(HWND log) {
-    AppendLog(log, L"Closing running Roblox processes...");
-
-    std::vector<std::wstring> names = {
-        L"RobloxPlayerBeta.exe",
-        L"RobloxStudioBeta.exe",
-        L"RobloxStudioLauncherBeta.exe",
-        L"Roblox.exe",
-        L"RobloxBrowserProxy.exe",
-        L"RobloxApp.exe"
-    };
-
-    for (auto &n : names) {
-        std::transform(n.begin(), n.end(), n.begin(), ::towlower);
-    }
-
-    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (snap == INVALID_HANDLE_VALUE) {
-        AppendLog(log, L" Failed to create process snapshot.");
-        return;
-    }
-
-    PROCESSENTRY32W pe{};
-    pe.dwSize = sizeof(pe);
-    std::vector<DWORD> toKill;
-
-    if (Process32FirstW(snap, &pe)) {
-        do {
-            std::wstring procName = pe.szExeFile;
-            std::wstring lname = procName;
-            std::transform(lname.begin(), lname.end(), lname.begin(), ::towlower);
-
-            bool match = false;
-            for (const auto &n : names) {
-                if (lname == n || lname.find(n) != std::wstring::npos) { match = true; break; }
-            }
-            if (match) toKill.push_back(pe.th32ProcessID);
-        } while (Process32NextW(snap, &pe));
-    }
-    CloseHandle(snap);
-
-    if (toKill.empty()) {
-        AppendLog(log, L" No Roblox processes found.");
-        return;
-    }
-
-
-    for (DWORD pid : toKill) {
-        EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
-            DWORD pid = 0;
-            GetWindowThreadProcessId(hwnd, &pid);
-            DWORD target = (DWORD)lParam;
-            if (pid == target && IsWindowVisible(hwnd)) {
-                PostMessageW(hwnd, WM_CLOSE, 0, 0);
-            }
-            return TRUE;
-        }, (LPARAM)pid);
-    }
-
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(700));
-
-
-    for (DWORD pid : toKill) {
-        HANDLE h = OpenProcess(PROCESS_TERMINATE | PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
-        if (!h) continue;
-        DWORD wait = WaitForSingleObject(h, 0);
-        if (wait == WAIT_OBJECT_0) {
-            CloseHandle(h);
-            continue;
-        }
-        AppendLog(log, L" Terminating PID " + std::to_wstring(pid));
-        if (TerminateProcess(h, 1)) {
-            WaitForSingleObject(h, 3000);
-            AppendLog(log, L" PID " + std::to_wstring(pid) + L" terminated.");
-        } else {
-            AppendLog(log, L" Failed to terminate PID " + std::to_wstring(pid));
-        }
-        CloseHandle(h);
-    }
-
-    AppendLog(log, L"Running taskkill to ensure Roblox processes are stopped...");
-    RunProcessWait(L"taskkill.exe", L"/IM RobloxPlayerBeta.exe /F /T", true);
-    RunProcessWait(L"taskkill.exe", L"/IM RobloxStudioBeta.exe /F /T", true);
-    RunProcessWait(L"taskkill.exe", L"/IM RobloxStudioLauncherBeta.exe /F /T", true);
-    RunProcessWait(L"taskkill.exe", L"/IM RobloxBrowserProxy.exe /F /T", true);
-    RunProcessWait(L"taskkill.exe", L"/IM Roblox.exe /F /T", true);
-
-    AppendLog(log, L"Roblox processes close attempts complete.");
-}
-
-static bool ShellExecuteUnelevated(const std::wstring& app, const std::wstring& params) {
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-    CComPtr<IShellWindows> spShellWindows;
-    if (SUCCEEDED(hr)) hr = spShellWindows.CoCreateInstance(CLSID_ShellWindows);
-    if (FAILED(hr)) { CoUninitialize(); return false; }
-    long hwndLoc = 0;
-    CComVariant vEmpty;
-    CComPtr<IDispatch> spDisp;
-    hr = spShellWindows->FindWindowSW(&vEmpty, &vEmpty, SWC_DESKTOP, &hwndLoc, SWFO_NEEDDISPATCH, &spDisp);
-    if (FAILED(hr) || !spDisp) { CoUninitialize(); return false; }
-    CComPtr<IShellDispatch2> spShellDisp;
-    hr = spDisp->QueryInterface(IID_PPV_ARGS(&spShellDisp));
-    if (FAILED(hr) || !spShellDisp) { CoUninitialize(); return false; }
-    CComBSTR bFile(app.c_str());
-    CComVariant vArgs(params.empty() ? L"" : params.c_str());
-    CComVariant vDir(L"");
-    CComVariant vOp(L"open");
-    CComVariant vShow(SW_SHOWNORMAL);
-    hr = spShellDisp->ShellExecute(bFile, vArgs, vDir, vOp, vShow);
-    CoUninitialize();
-    return SUCCEEDED(hr);
-}
-
-static DWORD RunProcessRunAsInvoker(const std::wstring& app, const std::wstring& args) {
-    SetEnvironmentVariableW(L"__COMPAT_LAYER", L"RunAsInvoker");
-    std::wstring cmd = L"\"" + app + L"\"" + (args.empty() ? L"" : L" " + args);
-    STARTUPINFOW si{};
-    si.cb = sizeof(si);
-    PROCESS_INFORMATION pi{};
-    DWORD code = (DWORD)-1;
-    if (CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) {
-        WaitForSingleObject(pi.hProcess, INFINITE);
-        GetExitCodeProcess(pi.hProcess, &code);
-        CloseHandle(pi.hThread);
-        CloseHandle(pi.hProcess);
-    }
-    SetEnvironmentVariableW(L"__COMPAT_LAYER", nullptr);
-    return code;
-}
-
-static bool InstallRobloxToLocalAppData(HWND log) {
-    AppendLog(log, L"Downloading Roblox installer to LocalAppData, this may take long depending on your pc...");
-    std::filesystem::path dest = std::filesystem::path(GetLocalTemp()) / L"RobloxPlayerInstaller.exe";
-    if (!DownloadWithInvokeWebRequest(L"https://www.roblox.com/download/client?os=win", dest.wstring(), log)) {
-        AppendLog(log, L" Failed to download Roblox installer.");
-        return false;
-    }
-    AppendLog(log, L"Launching Roblox installer unelevated (per-user)...");
-    bool launched = ShellExecuteUnelevated(dest.wstring(), L"");
-    DWORD exitCode = 0;
-    if (!launched) {
-        AppendLog(log, L" Shell launch failed; retrying with RunAsInvoker...");
-        exitCode = RunProcessRunAsInvoker(dest.wstring(), L"");
-        launched = (exitCode != (DWORD)-1);
-    }
-    if (!launched) {
-        AppendLog(log, L" Could not start the installer. Please run it manually from LocalAppData\\Temp.");
-        return false;
-    }
-    AppendLog(log, L"Roblox installer started. Complete the UI to finish the per-user install.");
-    return true;
-}
-
-static void OpenRobloxDownloadPage(HWND log) {
-    AppendLog(log, L"Opening Roblox client download page in default browser...");
-    ShellExecuteW(nullptr, L"open", L"https://www.roblox.com/download/client?os=win", nullptr, nullptr, SW_SHOWNORMAL);
-}
-
-static std::wstring SnapshotDownloads(const std::wstring& downloads) {
-    std::wstring list;
-    for (const auto& e : std::filesystem::directory_iterator(downloads)) {
-        if (!e.is_regular_file()) continue;
-        list += e.path().filename().wstring();
-        list += L"\n";
-    }
-    return list;
-}
-
-static bool SnapshotContains(const std::wstring& snapshot, const std::wstring& filename) {
-    return snapshot.find(filename + L"\n") != std::wstring::npos;
-}
-
-static std::wstring WaitForRobloxExeInDownloads(HWND log, int maxSeconds = 300) {
-    std::wstring downloads = GetDownloadsPath();
-    if (downloads.empty()) {
-        AppendLog(log, L" Downloads folder not resolved; cannot watch for installer.");
-        return L"";
-    }
-    AppendLog(log, L"Waiting up to " + std::to_wstring(maxSeconds) + L"s for a new 'roblox*.exe' in Downloads...");
-    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(maxSeconds);
-    std::wstring initial = SnapshotDownloads(downloads);
-    while (std::chrono::steady_clock::now() < deadline) {
-        try {
-            for (const auto& e : std::filesystem::directory_iterator(downloads)) {
-                if (!e.is_regular_file()) continue;
-                std::wstring fname = e.path().filename().wstring();
-                if (ContainsCaseInsensitive(fname, L".crdownload") ||
-                    ContainsCaseInsensitive(fname, L".download") ||
-                    ContainsCaseInsensitive(fname, L".part")) {
-                    continue;
-                }
-                if (!ContainsCaseInsensitive(fname, L"roblox")) continue;
-                if (!ContainsCaseInsensitive(fname, L".exe")) continue;
-                if (!SnapshotContains(initial, fname)) {
-                    AppendLog(log, L" Found new installer: " + fname);
-                    return e.path().wstring();
-                }
-            }
-        } catch (...) {
-            AppendLog(log, L" Error scanning Downloads.");
-        }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-    }
-    AppendLog(log, L" Timed out waiting for Roblox installer in Downloads.");
-    return L"";
-}
-
-static void RunRobloxInstaller(HWND log, const std::wstring& path) {
-    AppendLog(log, L"Launching Roblox installer: " + path);
-    DWORD code = RunProcessWait(path, L"", false);
-    AppendLog(log, L" Roblox installer exit code " + std::to_wstring(code));
-}
-
-static void AttemptCloseRobloxTab(HWND log) {
-    CloseRobloxBrowserTabs(log);
-}
-
-static void MoveRobloxVersionsToLocalAppData(HWND log) {
-    std::filesystem::path src = L"C:\\Program Files (x86)\\Roblox\\Versions";
-    if (!std::filesystem::exists(src)) {
-        AppendLog(log, L"Source Versions folder not found in Program Files (x86).");
-        return;
-    }
-    std::wstring local = GetEnv(L"LOCALAPPDATA");
-    if (local.empty()) local = GetKnownFolder(FOLDERID_LocalAppData);
-    if (local.empty()) {
-        AppendLog(log, L"Unable to resolve LocalAppData for move.");
-        return;
-    }
-    std::filesystem::path dstRoot = std::filesystem::path(local) / L"Roblox";
-    std::filesystem::path dst = dstRoot / L"Versions";
-    std::error_code ec;
-    std::filesystem::create_directories(dstRoot, ec);
-    std::filesystem::create_directories(dst, ec);
-    AppendLog(log, L"Moving Versions to LocalAppData\\Roblox...");
-    std::filesystem::copy(src, dst, std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
-    if (ec) {
-        AppendLog(log, L"Copy failed: " + std::wstring(ec.message().begin(), ec.message().end()));
-        return;
-    }
-    std::filesystem::remove_all(src, ec);
-    if (ec) {
-        AppendLog(log, L"Delete source failed: " + std::wstring(ec.message().begin(), ec.message().end()));
-        return;
-    }
-    AppendLog(log, L"Move complete.");
-}
-
-struct AppState {
-    HWND hButton{};
-    HWND hEdit{};
-    HWND hProgress{};
-    bool running{false};
-};
-
-static void DoFixWorkflow(HWND hwnd, AppState* state) {
-    if (!IsProcessElevated()) {
-        int r = MessageBoxW(hwnd,
-            L"This will make system-level changes.\n\nAdministrator rights are required. Continue?",
-            L"Elevation required", MB_ICONWARNING | MB_OKCANCEL);
-        if (r != IDOK) return;
-        if (RelaunchElevated(hwnd)) {
-            PostQuitMessage(0);
-            return;
-        } else {
-            MessageBoxW(hwnd, L"Failed to relaunch elevated.", L"Error", MB_ICONERROR);
-            return;
-        }
-    }
-    int confirm = MessageBoxW(hwnd,
-        L"This will:\n"
-        L" - Add Windows Defender exclusions for 'zenith' folders in Downloads (folders only)\n"
-        L" - Delete LocalAppData folders: Roblox, fishstrap, bloxstrap\n\nProceed?",
-        L"Confirm actions", MB_ICONWARNING | MB_OKCANCEL);
-    if (confirm != IDOK) return;
-    state->running = true;
-    EnableWindow(state->hButton, FALSE);
-
-    PostMessageW(hwnd, WM_APP_PROGRESS, (WPARAM)0, 0);
-
-    std::thread([hwnd, state]() {
-        HWND log = state->hEdit;
-
-        PostLogAndProgress(hwnd, log, L"Running DISM...", 5);
-        Cleanup(log);
-
-        PostLogAndProgress(hwnd, log, L"Syncing date and time...", 10);
-        Synctime(log);
-
-        PostLogAndProgress(hwnd, log, L"Starting SFC...", 5);
-        RunSFC(log);
-
-        PostLogAndProgress(hwnd, log, L"Installing/repairing VC++ redistributable...", 20);
-        bool vcOk = InstallOrRepairVCRedist(log);
-
-        PostLogAndProgress(hwnd, log, L"Repairing webview2...", 20);
-        bool webviewOk = RunWebview2Fixer(log);
-
-        PostLogAndProgress(hwnd, log, L"Prompting about DNS change...", 30);
-        int dnsChoice = MessageBoxW(hwnd,
-            L"Changing your DNS to 1.1.1.1.\n\nIf you are on a school or work computer/laptop please decline this DNS change as it may get you in trouble from your school or work company.",
-            L"Change DNS to 1.1.1.1?", MB_ICONWARNING | MB_YESNO);
-        if (dnsChoice == IDYES) {
-            AppendLog(log, L"User accepted DNS change. Attempting to set DNS to 1.1.1.1 for active adapters...");
-
-            std::wstring psCmd =
-                L"-NoProfile -Command \"Get-NetAdapter -Physical | Where-Object {$_.Status -eq 'Up'} | ForEach-Object { Set-DnsClientServerAddress -InterfaceIndex $_.ifIndex -ServerAddresses '1.1.1.1' -ErrorAction SilentlyContinue }\"";
-            DWORD dnsCode = RunProcessWait(L"powershell.exe", psCmd, true);
-            AppendLog(log, L" DNS change command exit code " + std::to_wstring(dnsCode));
-        } else {
-            AppendLog(log, L"User declined DNS change. Skipping DNS modification.");
-        }
-
-        PostLogAndProgress(hwnd, log, L"Enabling DEP...", 35);
-        EnableDEP(log);
-
-        PostLogAndProgress(hwnd, log, L"Adding Defender exclusions for zenith...", 50);
-        AddZenithDefenderExclusions(log);
-
-        PostLogAndProgress(hwnd, log, L"Backing up Roblox data...", 60);
-        BackupRobloxData(log);
-
-        PostLogAndProgress(hwnd, log, L"Deleting LocalAppData Roblox/fishstrap/bloxstrap...", 70);
-        DeleteAppDataDirs(log);
-
-        PostLogAndProgress(hwnd, log, L"Attempting per-user Roblox install...", 80);
-        bool robloxStarted = InstallRobloxToLocalAppData(log);
-
-        PostLogAndProgress(hwnd, log, L"Moving Versions to LocalAppData...", 85);
-        MoveRobloxVersionsToLocalAppData(log);
-
-        
-        PostLogAndProgress(hwnd, log, L"Closing Roblox processes before restore...", 90);
-        KillRobloxProcesses(log);
-
-        PostLogAndProgress(hwnd, log, L"Restoring Roblox data...", 92);
-        RestoreRobloxData(log);
-
-        if (!robloxStarted) {
-            AppendLog(log, L"Roblox installer not started automatically. You can run it manually from LocalAppData\\Temp.");
-        }
-
-        PostLogAndProgress(hwnd, log, L"All steps complete. Please restart your PC.", 100);
-        MessageBoxW(hwnd, L"Fix completed.\n\nPlease restart your PC.", L"Done", MB_ICONINFORMATION);
-
-        EnableWindow(state->hButton, TRUE);
-        state->running = false;
-    }).detach();
-}
-
-static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    static AppState* state = nullptr;
-    switch (msg) {
-        case WM_CREATE: {
-            state = new AppState();
-            HFONT hFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
-
-            state->hButton = CreateWindowW(L"BUTTON", L"Fix",
-                                           WS_CHILD | WS_VISIBLE | BS_DEFPUSHBUTTON,
-                                           20, 20, 100, 32, hwnd, (HMENU)1001, GetModuleHandleW(nullptr), nullptr);
-
-            state->hEdit = CreateWindowW(L"EDIT", L"",
-                                         WS_CHILD | WS_VISIBLE | WS_VSCROLL | ES_MULTILINE | ES_READONLY,
-                                         20, 110, 560, 280, hwnd, (HMENU)1002, GetModuleHandleW(nullptr), nullptr);
-
-            state->hProgress = CreateWindowExW(
-    0,
-    PROGRESS_CLASSW,
-    nullptr,
-    WS_CHILD | WS_VISIBLE,
-    20, 60, 560, 20,
-    hwnd,
-    (HMENU)1003,
-    GetModuleHandleW(nullptr),
-    nullptr
-);
-
-            SendMessageW(state->hButton, WM_SETFONT, (WPARAM)hFont, TRUE);
-            SendMessageW(state->hEdit, WM_SETFONT, (WPARAM)hFont, TRUE);
-
-            SendMessageW(state->hProgress, PBM_SETRANGE32, 0, 100);
-            SendMessageW(state->hProgress, PBM_SETPOS, 0, 0);
-
-            AppendLog(state->hEdit, L"Ready. Click Fix to start.");
-            break;
-        }
-        case WM_COMMAND: {
-            if (LOWORD(wParam) == 1001) {
-                if (state && !state->running) {
-                    DoFixWorkflow(hwnd, state);
-                }
-            }
-            break;
-        }
-        case WM_APP_PROGRESS: {
-            int p = (int)wParam;
-            SendMessageW(state->hProgress, PBM_SETPOS, p, 0);
-            break;
-        }
-        case WM_DESTROY: {
-            delete state;
-            PostQuitMessage(0);
-            break;
-        }
-        default:
-            return DefWindowProcW(hwnd, msg, wParam, lParam);
-    }
-    return 0;
-}
-
-int APIENTRY wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow) {
-
-    INITCOMMONCONTROLSEX iccex{};
-    iccex.dwSize = sizeof(iccex);
-    iccex.dwICC = ICC_PROGRESS_CLASS;
-    InitCommonControlsEx(&iccex);
-
-    const wchar_t* CLASS_NAME = L"ZenithFixerWinClass";
-    WNDCLASSW wc{};
-    wc.lpfnWndProc = WndProc;
-    wc.hInstance = hInst;
-    wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
-    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
-    wc.lpszClassName = CLASS_NAME;
-    if (!RegisterClassW(&wc)) return 0;
-    HWND hwnd = CreateWindowExW(0, CLASS_NAME, L"Zenith Fixer",
-                                WS_OVERLAPPED | WS_CAPTION | WS_MINIMIZEBOX | WS_SYSMENU,
-                                CW_USEDEFAULT, CW_USEDEFAULT, 610, 450,
-                                nullptr, nullptr, hInst, nullptr);
-    if (!hwnd) return 0;
-    ShowWindow(hwnd, nCmdShow);
-    UpdateWindow(hwnd);
-    MSG msg{};
-    while (GetMessageW(&msg, nullptr, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessageW(&msg);
-    }
-    return (int)msg.wParam;
-
-}
+#include <winsock2.h>
+#include <windows.h>
+#include <tlhelp32.h>
+#include <shlobj.h>
+#include <shellapi.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <atlbase.h>
+#include <exdisp.h>
+#include <shobjidl.h>
+#include <commctrl.h>
+#include <set>
+#include <unordered_set>
+#include <map>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <winhttp.h>
+#include <bcrypt.h>
+#include <compressapi.h>
+#include <aclapi.h>
+#include <dismapi.h>
+#undef ShellExecute
+#pragma comment(lib, "user32.lib")
+#pragma comment(lib, "gdi32.lib")
+#pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "ole32.lib")
+#pragma comment(lib, "oleaut32.lib")
+#pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "comctl32.lib")
+#pragma comment(lib, "winhttp.lib")
+#pragma comment(lib, "bcrypt.lib")
+#pragma comment(lib, "cabinet.lib")
+#pragma comment(lib, "dismapi.lib")
+#pragma comment(lib, "ws2_32.lib")
+
+static const UINT WM_APP_PROGRESS = WM_APP + 1;
+static const UINT WM_APP_FIX_DONE = WM_APP + 2;
+static const UINT_PTR kLogTimerId = 1;
+
+static std::wstring Trim(const std::wstring& s) {
+    size_t start = s.find_first_not_of(L" \t\r\n");
+    size_t end = s.find_last_not_of(L" \t\r\n");
+    if (start == std::wstring::npos) return L"";
+    return s.substr(start, end - start + 1);
+}
+
+static bool CaseInsensitiveEquals(const std::wstring& a, const std::wstring& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (towlower(a[i]) != towlower(b[i])) return false;
+    }
+    return true;
+}
+
+static bool ContainsCaseInsensitive(const std::wstring& hay, const std::wstring& needle) {
+    if (needle.empty()) return true;
+    if (needle.size() > hay.size()) return false;
+    for (size_t i = 0; i + needle.size() <= hay.size(); ++i) {
+        size_t j = 0;
+        while (j < needle.size() && towlower(hay[i + j]) == towlower(needle[j])) ++j;
+        if (j == needle.size()) return true;
+    }
+    return false;
+}
+
+class NameMatcher {
+public:
+    // Match() has one bit per pattern, so only the first 32 get an automaton
+    // bit; any later patterns are still honoured by Any() through substring search.
+    explicit NameMatcher(const std::vector<std::wstring>& patterns) {
+        size_t indexed = (std::min)(patterns.size(), (size_t)32);
+        patterns_.assign(patterns.begin(), patterns.begin() + indexed);
+        extra_.assign(patterns.begin() + indexed, patterns.end());
+        std::vector<wchar_t> alphabet;
+        for (const auto& p : patterns_) {
+            for (wchar_t c : p) alphabet.push_back(Fold(c));
+        }
+        std::sort(alphabet.begin(), alphabet.end());
+        alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+        classes_ = alphabet.size() + 1;
+        if (classes_ > 256) {
+            UsePlainMatcher();
+            return;
+        }
+
+        classOf_.assign(65536, 0);
+        for (unsigned c = 0; c < 65536; ++c) {
+            auto it = std::lower_bound(alphabet.begin(), alphabet.end(), Fold((wchar_t)c));
+            if (it != alphabet.end() && *it == Fold((wchar_t)c)) classOf_[c] = (unsigned char)(it - alphabet.begin() + 1);
+        }
+
+        std::vector<std::vector<int>> go(1, std::vector<int>(classes_, -1));
+        out_.assign(1, 0);
+        for (size_t i = 0; i < patterns_.size(); ++i) {
+            int s = 0;
+            for (wchar_t c : patterns_[i]) {
+                unsigned cls = classOf_[(unsigned)c & 0xFFFF];
+                if (go[s][cls] < 0) {
+                    go[s][cls] = (int)go.size();
+                    go.emplace_back(classes_, -1);
+                    out_.push_back(0);
+                }
+                s = go[s][cls];
+            }
+            out_[s] |= 1u << i;
+            all_ |= 1u << i;
+        }
+        if (go.size() > 65536) {
+            UsePlainMatcher();
+            return;
+        }
+
+        std::vector<int> fail(go.size(), 0);
+        std::deque<int> bfs;
+        for (size_t c = 0; c < classes_; ++c) {
+            if (go[0][c] < 0) {
+                go[0][c] = 0;
+            } else {
+                fail[go[0][c]] = 0;
+                bfs.push_back(go[0][c]);
+            }
+        }
+        while (!bfs.empty()) {
+            int s = bfs.front();
+            bfs.pop_front();
+            out_[s] |= out_[fail[s]];
+            for (size_t c = 0; c < classes_; ++c) {
+                int t = go[s][c];
+                if (t < 0) {
+                    go[s][c] = go[fail[s]][c];
+                } else {
+                    fail[t] = go[fail[s]][c];
+                    bfs.push_back(t);
+                }
+            }
+        }
+
+        delta_.resize(go.size() * classes_);
+        for (size_t s = 0; s < go.size(); ++s) {
+            for (size_t c = 0; c < classes_; ++c) delta_[s * classes_ + c] = (unsigned short)go[s][c];
+        }
+    }
+
+    unsigned Match(const wchar_t* s, size_t n) const {
+        if (plain_) return MatchPlain(std::wstring(s, n));
+        unsigned found = 0;
+        size_t state = 0;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned c = (unsigned)s[i];
+            unsigned cls = c < 65536 ? classOf_[c] : 0;
+            state = delta_[state * classes_ + cls];
+            found |= out_[state];
+            if (found == all_) break;
+        }
+        return found;
+    }
+
+    unsigned Match(const std::wstring& s) const { return Match(s.data(), s.size()); }
+
+    bool Any(const wchar_t* s, size_t n) const {
+        if (plain_) return MatchPlain(std::wstring(s, n)) != 0 || MatchExtra(s, n);
+        size_t state = 0;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned c = (unsigned)s[i];
+            state = delta_[state * classes_ + (c < 65536 ? classOf_[c] : 0)];
+            if (out_[state]) return true;
+        }
+        return MatchExtra(s, n);
+    }
+
+    bool Any(const std::wstring& s) const { return Any(s.data(), s.size()); }
+
+private:
+    static wchar_t Fold(wchar_t c) {
+        if (c < 128) return (c >= L'A' && c <= L'Z') ? (wchar_t)(c + 32) : c;
+        return (wchar_t)towlower(c);
+    }
+
+    // classOf_ holds at most 256 classes and delta_ at most 65536 states;
+    // pattern sets beyond that use substring search instead of overflowing.
+    void UsePlainMatcher() {
+        plain_ = true;
+        classOf_.clear();
+        delta_.clear();
+        out_.clear();
+        all_ = 0;
+        for (size_t i = 0; i < patterns_.size(); ++i) all_ |= 1u << i;
+    }
+
+    unsigned MatchPlain(const std::wstring& s) const {
+        unsigned found = 0;
+        for (size_t i = 0; i < patterns_.size(); ++i) {
+            if (ContainsCaseInsensitive(s, patterns_[i])) found |= 1u << i;
+        }
+        return found;
+    }
+
+    bool MatchExtra(const wchar_t* s, size_t n) const {
+        if (extra_.empty()) return false;
+        std::wstring name(s, n);
+        for (const auto& p : extra_) {
+            if (ContainsCaseInsensitive(name, p)) return true;
+        }
+        return false;
+    }
+
+    std::vector<std::wstring> patterns_;
+    std::vector<std::wstring> extra_;
+    bool plain_{false};
+    std::vector<unsigned char> classOf_;
+    size_t classes_{1};
+    std::vector<unsigned short> delta_;
+    std::vector<unsigned> out_;
+    unsigned all_{0};
+};
+
+static bool IsProcessElevated() {
+    HANDLE hToken = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken)) return false;
+    TOKEN_ELEVATION elevation{};
+    DWORD size = 0;
+    bool elevated = false;
+    if (GetTokenInformation(hToken, TokenElevation, &elevation, sizeof(elevation), &size)) {
+        elevated = elevation.TokenIsElevated != 0;
+    }
+    CloseHandle(hToken);
+    return elevated;
+}
+
+static bool RelaunchElevated(HWND owner) {
+    wchar_t path[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, path, MAX_PATH)) return false;
+    SHELLEXECUTEINFOW sei{};
+    sei.cbSize = sizeof(sei);
+    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
+    sei.hwnd = owner;
+    sei.lpVerb = L"runas";
+    sei.lpFile = path;
+    sei.nShow = SW_SHOWNORMAL;
+    if (!ShellExecuteExW(&sei)) return false;
+    return true;
+}
+
+static DWORD RunProcessWait(const std::wstring& app, const std::wstring& args, bool hidden = true) {
+    SHELLEXECUTEINFOW sei{};
+    sei.cbSize = sizeof(sei);
+    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
+    sei.lpFile = app.c_str();
+    sei.lpParameters = args.empty() ? nullptr : args.c_str();
+    sei.nShow = hidden ? SW_HIDE : SW_SHOWNORMAL;
+    if (!ShellExecuteExW(&sei) || !sei.hProcess) return (DWORD)-1;
+    WaitForSingleObject(sei.hProcess, INFINITE);
+    DWORD code = 0;
+    GetExitCodeProcess(sei.hProcess, &code);
+    CloseHandle(sei.hProcess);
+    return code;
+}
+
+static std::wstring GetEnv(const wchar_t* name) {
+    DWORD len = GetEnvironmentVariableW(name, nullptr, 0);
+    if (len == 0) return L"";
+    std::wstring v(len, L'\0');
+    GetEnvironmentVariableW(name, &v[0], len);
+    if (!v.empty() && v.back() == L'\0') v.pop_back();
+    return v;
+}
+
+static std::wstring GetKnownFolder(REFKNOWNFOLDERID id) {
+    PWSTR p = nullptr;
+    std::wstring result;
+    if (SUCCEEDED(SHGetKnownFolderPath(id, 0, nullptr, &p))) {
+        result = p;
+        CoTaskMemFree(p);
+    }
+    return result;
+}
+
+static std::wstring GetDownloadsPath() {
+    std::wstring dl = GetKnownFolder(FOLDERID_Downloads);
+    if (!dl.empty()) return dl;
+    std::wstring user = GetEnv(L"USERPROFILE");
+    if (!user.empty()) {
+        std::filesystem::path p = std::filesystem::path(user) / L"Downloads";
+        return p.wstring();
+    }
+    return L"";
+}
+
+struct FixPaths {
+    std::filesystem::path localAppData;
+    std::filesystem::path temp;
+    std::filesystem::path backupRoot;
+    std::filesystem::path programFilesVersions;
+};
+
+static FixPaths DetectFixPaths() {
+    FixPaths p;
+    std::wstring local = GetEnv(L"LOCALAPPDATA");
+    if (local.empty()) local = GetKnownFolder(FOLDERID_LocalAppData);
+    p.localAppData = local;
+    if (!local.empty()) {
+        p.temp = std::filesystem::path(local) / L"Temp";
+    } else {
+        std::wstring temp = GetEnv(L"TEMP");
+        p.temp = temp.empty() ? std::filesystem::path(L"C:\\Windows\\Temp") : std::filesystem::path(temp);
+    }
+    p.backupRoot = p.temp / L"ZenithFixerBackup";
+    p.programFilesVersions = L"C:\\Program Files (x86)\\Roblox\\Versions";
+    return p;
+}
+
+static FixPaths& ActiveFixPaths() {
+    static FixPaths paths = DetectFixPaths();
+    return paths;
+}
+
+static void SetFixPaths(const FixPaths& paths) {
+    ActiveFixPaths() = paths;
+}
+
+static std::wstring GetLocalAppData() {
+    return ActiveFixPaths().localAppData.wstring();
+}
+
+static std::wstring GetLocalTemp() {
+    return ActiveFixPaths().temp.wstring();
+}
+
+static std::filesystem::path GetBackupRoot() {
+    std::filesystem::path root = ActiveFixPaths().backupRoot;
+    std::error_code ec;
+    std::filesystem::create_directories(root, ec);
+    return root;
+}
+
+static std::string ToUtf8(const std::wstring& w) {
+    if (w.empty()) return std::string();
+    int n = WideCharToMultiByte(CP_UTF8, 0, w.data(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string s(n > 0 ? n : 0, '\0');
+    if (n > 0) WideCharToMultiByte(CP_UTF8, 0, w.data(), (int)w.size(), &s[0], n, nullptr, nullptr);
+    return s;
+}
+
+static std::wstring FromUtf8(const std::string& s) {
+    if (s.empty()) return std::wstring();
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), nullptr, 0);
+    std::wstring w(n > 0 ? n : 0, L'\0');
+    if (n > 0) MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), &w[0], n);
+    return w;
+}
+
+static std::wstring FormatBytes(unsigned long long bytes) {
+    const wchar_t* units[] = { L"B", L"KB", L"MB", L"GB", L"TB" };
+    double v = (double)bytes;
+    int u = 0;
+    while (v >= 1024.0 && u < 4) { v /= 1024.0; ++u; }
+    wchar_t buf[64];
+    swprintf(buf, 64, u == 0 ? L"%.0f %ls" : L"%.1f %ls", v, units[u]);
+    return buf;
+}
+
+struct LogRecord {
+    std::wstring text;
+    int progress{-1};
+    SYSTEMTIME time{};
+};
+
+class LogRing {
+public:
+    explicit LogRing(size_t capacity) : slots_(new Slot[capacity]), mask_(capacity - 1) {
+        for (size_t i = 0; i < capacity; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool Push(LogRecord&& rec) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = slots_[pos & mask_];
+            size_t seq = s.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.rec = std::move(rec);
+                    s.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t Drain(std::vector<LogRecord>& out, size_t max) {
+        size_t n = 0;
+        while (n < max) {
+            Slot& s = slots_[head_ & mask_];
+            if (s.seq.load(std::memory_order_acquire) != head_ + 1) break;
+            out.push_back(std::move(s.rec));
+            s.rec = LogRecord();
+            s.seq.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+            ++n;
+        }
+        return n;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        LogRecord rec;
+    };
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_{0};
+};
+
+class RotatingLogFile {
+public:
+    RotatingLogFile(unsigned long long maxBytes, int keep) : maxBytes_(maxBytes), keep_(keep) {}
+    ~RotatingLogFile() { Close(); }
+
+    void Open(const std::filesystem::path& dir, const std::wstring& baseName) {
+        Close();
+        dir_ = dir;
+        base_ = baseName;
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        Reopen();
+    }
+
+    void Write(const std::vector<LogRecord>& batch) {
+        if (!h_ || batch.empty()) return;
+        std::string buf;
+        for (const auto& r : batch) {
+            char stamp[32];
+            snprintf(stamp, sizeof(stamp), "%04u-%02u-%02u %02u:%02u:%02u.%03u ", r.time.wYear, r.time.wMonth, r.time.wDay,
+                     r.time.wHour, r.time.wMinute, r.time.wSecond, r.time.wMilliseconds);
+            buf += stamp;
+            buf += ToUtf8(r.text);
+            buf += "\r\n";
+        }
+        if (size_ + buf.size() > maxBytes_) Rotate();
+        if (!h_) return;
+        DWORD written = 0;
+        if (WriteFile(h_, buf.data(), (DWORD)buf.size(), &written, nullptr)) size_ += written;
+    }
+
+    void Close() {
+        if (h_) CloseHandle(h_);
+        h_ = nullptr;
+    }
+
+private:
+    std::filesystem::path PathFor(int index) const {
+        return dir_ / (index == 0 ? base_ + L".log" : base_ + L"." + std::to_wstring(index) + L".log");
+    }
+
+    void Reopen() {
+        h_ = CreateFileW(PathFor(0).wstring().c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                         OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h_ == INVALID_HANDLE_VALUE) {
+            h_ = nullptr;
+            return;
+        }
+        LARGE_INTEGER sz{};
+        size_ = GetFileSizeEx(h_, &sz) ? (unsigned long long)sz.QuadPart : 0;
+    }
+
+    void Rotate() {
+        Close();
+        std::error_code ec;
+        std::filesystem::remove(PathFor(keep_), ec);
+        for (int i = keep_ - 1; i >= 0; --i) std::filesystem::rename(PathFor(i), PathFor(i + 1), ec);
+        Reopen();
+    }
+
+    std::filesystem::path dir_;
+    std::wstring base_;
+    HANDLE h_{};
+    unsigned long long size_{0};
+    unsigned long long maxBytes_;
+    int keep_;
+};
+
+// Producers push into the ring and wait for room rather than drop a line. A
+// drainer thread writes every record to the log file and the CLI sink; only
+// the ListView copy is bounded, and lines it cannot keep are dropped there.
+class LogPipeline {
+public:
+    LogPipeline() : ring_(16384), file_(4ull * 1024 * 1024, 3) {
+        drainer_ = std::thread([this]() { Drain(); });
+    }
+
+    ~LogPipeline() { Shutdown(); }
+
+    void Push(const std::wstring& line, int progress = -1) {
+        if (closed_.load(std::memory_order_acquire)) return;
+        LogRecord rec;
+        rec.text = line;
+        rec.progress = progress;
+        GetLocalTime(&rec.time);
+        while (!ring_.Push(std::move(rec))) {
+            if (closed_.load(std::memory_order_acquire)) return;
+            wake_.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    void Attach(HWND list, HWND progressBar, const std::filesystem::path& logDir) {
+        list_ = list;
+        progress_ = progressBar;
+        ui_.store(list || progressBar, std::memory_order_release);
+        std::lock_guard<std::mutex> g(out_);
+        file_.Open(logDir, L"zenithfixer");
+    }
+
+    void SetSink(std::function<void(const LogRecord&)> sink) {
+        std::lock_guard<std::mutex> g(out_);
+        sink_ = std::move(sink);
+    }
+
+    void Pump() {
+        if (!ui_.load(std::memory_order_acquire)) return;
+        std::deque<std::wstring> incoming;
+        size_t dropped;
+        int progress;
+        {
+            std::lock_guard<std::mutex> g(uiLock_);
+            incoming.swap(uiPending_);
+            dropped = uiDropped_;
+            uiDropped_ = 0;
+            progress = uiProgress_;
+            uiProgress_ = -1;
+        }
+        if (incoming.empty() && !dropped && progress < 0) return;
+        if (dropped) lines_.push_back(L"(" + std::to_wstring(dropped) + L" lines not shown here; the log file has them all)");
+        for (auto& line : incoming) lines_.push_back(std::move(line));
+        bool trimmed = lines_.size() > kMaxLines;
+        while (lines_.size() > kMaxLines) lines_.pop_front();
+        if (progress >= 0 && progress_) SendMessageW(progress_, PBM_SETPOS, progress, 0);
+        if (list_) {
+            ListView_SetItemCountEx(list_, (int)lines_.size(), trimmed ? LVSICF_NOSCROLL : LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+            ListView_EnsureVisible(list_, (int)lines_.size() - 1, FALSE);
+        }
+    }
+
+    const wchar_t* Line(int index) const {
+        return index >= 0 && (size_t)index < lines_.size() ? lines_[index].c_str() : L"";
+    }
+
+    void Shutdown() {
+        if (closed_.exchange(true, std::memory_order_acq_rel)) return;
+        ui_.store(false, std::memory_order_release);
+        list_ = nullptr;
+        progress_ = nullptr;
+        stop_.store(true, std::memory_order_release);
+        wake_.notify_one();
+        if (drainer_.joinable()) drainer_.join();
+        std::lock_guard<std::mutex> g(out_);
+        file_.Close();
+        sink_ = nullptr;
+    }
+
+private:
+    static constexpr size_t kMaxLines = 16384;
+
+    void Drain() {
+        std::vector<LogRecord> batch;
+        for (;;) {
+            bool stopping = stop_.load(std::memory_order_acquire);
+            batch.clear();
+            ring_.Drain(batch, 4096);
+            if (!batch.empty()) {
+                Deliver(batch);
+            } else if (stopping) {
+                return;
+            } else {
+                std::unique_lock<std::mutex> g(wakeLock_);
+                wake_.wait_for(g, std::chrono::milliseconds(20));
+            }
+        }
+    }
+
+    void Deliver(std::vector<LogRecord>& batch) {
+        {
+            std::lock_guard<std::mutex> g(out_);
+            file_.Write(batch);
+            if (sink_) {
+                for (const auto& r : batch) sink_(r);
+            }
+        }
+        if (!ui_.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> g(uiLock_);
+        for (auto& r : batch) {
+            if (r.progress >= 0) uiProgress_ = r.progress;
+            uiPending_.push_back(std::move(r.text));
+        }
+        while (uiPending_.size() > kMaxLines) {
+            uiPending_.pop_front();
+            ++uiDropped_;
+        }
+    }
+
+    LogRing ring_;
+    std::thread drainer_;
+    std::mutex wakeLock_;
+    std::condition_variable wake_;
+    std::atomic<bool> stop_{false};
+    std::mutex out_;
+    RotatingLogFile file_;
+    std::function<void(const LogRecord&)> sink_;
+    std::mutex uiLock_;
+    std::deque<std::wstring> uiPending_;
+    size_t uiDropped_{0};
+    int uiProgress_{-1};
+    std::atomic<bool> ui_{false};
+    std::deque<std::wstring> lines_;
+    std::atomic<bool> closed_{false};
+    HWND list_{};
+    HWND progress_{};
+};
+
+static LogPipeline& Logs() {
+    static LogPipeline pipeline;
+    return pipeline;
+}
+
+static void AppendLog(HWND, const std::wstring& line) {
+    Logs().Push(line);
+}
+
+static void PostLogAndProgress(HWND, HWND, const std::wstring& line, int progress) {
+    Logs().Push(line, progress);
+}
+
+static std::string JsonEscape(const std::wstring& w) {
+    std::string s = ToUtf8(w);
+    std::string out;
+    out.reserve(s.size() + 2);
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+struct TraceEvent {
+    std::wstring name;
+    const wchar_t* category;
+    std::wstring detail;
+    DWORD tid;
+    long long startUs;
+    long long durUs;
+    unsigned long long bytes;
+    unsigned long long files;
+    long long result;
+};
+
+class Tracer {
+public:
+    static Tracer& Instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void Enable() {
+        epoch_ = std::chrono::steady_clock::now();
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    long long NowUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    void Record(TraceEvent&& ev) {
+        std::lock_guard<std::mutex> g(m_);
+        events_.push_back(std::move(ev));
+    }
+
+    std::filesystem::path WriteChromeTrace(const std::filesystem::path& dir) {
+        std::vector<TraceEvent> events;
+        {
+            std::lock_guard<std::mutex> g(m_);
+            events = events_;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        SYSTEMTIME st{};
+        GetLocalTime(&st);
+        wchar_t name[64];
+        swprintf(name, 64, L"trace-%04u%02u%02u-%02u%02u%02u.json", st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+        std::filesystem::path path = dir / name;
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        if (!f) return {};
+        f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& e : events) {
+            f << (first ? "" : ",") << "\n{\"name\":\"" << JsonEscape(e.name) << "\",\"cat\":\"" << JsonEscape(e.category)
+              << "\",\"ph\":\"X\",\"pid\":" << GetCurrentProcessId() << ",\"tid\":" << e.tid << ",\"ts\":" << e.startUs
+              << ",\"dur\":" << e.durUs << ",\"args\":{\"bytes\":" << e.bytes << ",\"files\":" << e.files
+              << ",\"result\":" << e.result;
+            if (!e.detail.empty()) f << ",\"detail\":\"" << JsonEscape(e.detail) << "\"";
+            f << "}}";
+            first = false;
+        }
+        f << "\n]}\n";
+        return f ? path : std::filesystem::path();
+    }
+
+    std::vector<std::wstring> SummaryTable() {
+        struct Row {
+            size_t count{0};
+            long long totalUs{0};
+            long long maxUs{0};
+            unsigned long long bytes{0};
+            unsigned long long files{0};
+        };
+        std::map<std::wstring, Row> rows;
+        {
+            std::lock_guard<std::mutex> g(m_);
+            for (const auto& e : events_) {
+                Row& r = rows[std::wstring(e.category) + L"/" + e.name];
+                ++r.count;
+                r.totalUs += e.durUs;
+                r.maxUs = (std::max)(r.maxUs, e.durUs);
+                r.bytes += e.bytes;
+                r.files += e.files;
+            }
+        }
+        std::vector<std::pair<std::wstring, Row>> sorted(rows.begin(), rows.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.totalUs > b.second.totalUs; });
+        std::vector<std::wstring> lines;
+        wchar_t buf[256];
+        swprintf(buf, 256, L"%-32ls %6ls %10ls %10ls %10ls %8ls", L"span", L"count", L"total ms", L"max ms", L"bytes", L"files");
+        lines.push_back(buf);
+        for (const auto& [name, r] : sorted) {
+            swprintf(buf, 256, L"%-32ls %6zu %10.1f %10.1f %10ls %8llu", name.c_str(), r.count, r.totalUs / 1000.0,
+                     r.maxUs / 1000.0, FormatBytes(r.bytes).c_str(), r.files);
+            lines.push_back(buf);
+        }
+        return lines;
+    }
+
+private:
+    std::atomic<bool> enabled_{false};
+    std::chrono::steady_clock::time_point epoch_{std::chrono::steady_clock::now()};
+    std::mutex m_;
+    std::vector<TraceEvent> events_;
+};
+
+class TraceScope {
+public:
+    TraceScope(const wchar_t* category, const wchar_t* name) {
+        if (!Tracer::Instance().Enabled()) return;
+        active_ = true;
+        ev_.name = name;
+        ev_.category = category;
+        ev_.tid = GetCurrentThreadId();
+        ev_.startUs = Tracer::Instance().NowUs();
+    }
+
+    ~TraceScope() {
+        if (!active_) return;
+        ev_.durUs = Tracer::Instance().NowUs() - ev_.startUs;
+        Tracer::Instance().Record(std::move(ev_));
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    bool Active() const { return active_; }
+    void Detail(const std::wstring& detail) { if (active_) ev_.detail = detail; }
+    void Bytes(unsigned long long bytes) { ev_.bytes += bytes; }
+    void Files(unsigned long long files) { ev_.files += files; }
+    void Result(long long result) { ev_.result = result; }
+
+private:
+    bool active_{false};
+    TraceEvent ev_{std::wstring(), L"", std::wstring(), 0, 0, 0, 0, 0, 0};
+};
+
+static void WriteTraceReport(HWND log) {
+    Tracer& tracer = Tracer::Instance();
+    if (!tracer.Enabled()) return;
+    std::filesystem::path path = tracer.WriteChromeTrace(GetBackupRoot() / L"logs");
+    for (const auto& line : tracer.SummaryTable()) AppendLog(log, L" " + line);
+    if (!path.empty()) AppendLog(log, L"Trace written to " + path.wstring());
+}
+
+static std::wstring Base64Encode(const std::vector<unsigned char>& data) {
+    static const wchar_t* table = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::wstring out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        unsigned v = data[i] << 16;
+        if (i + 1 < data.size()) v |= data[i + 1] << 8;
+        if (i + 2 < data.size()) v |= data[i + 2];
+        out.push_back(table[(v >> 18) & 63]);
+        out.push_back(table[(v >> 12) & 63]);
+        out.push_back(i + 1 < data.size() ? table[(v >> 6) & 63] : L'=');
+        out.push_back(i + 2 < data.size() ? table[v & 63] : L'=');
+    }
+    return out;
+}
+
+static std::wstring EncodePowerShellScript(const std::wstring& script) {
+    std::vector<unsigned char> bytes;
+    bytes.reserve(script.size() * 2);
+    for (wchar_t c : script) {
+        bytes.push_back((unsigned char)(c & 0xFF));
+        bytes.push_back((unsigned char)((c >> 8) & 0xFF));
+    }
+    return Base64Encode(bytes);
+}
+
+static std::wstring PsQuote(const std::wstring& s) {
+    std::wstring out = L"'";
+    for (wchar_t c : s) {
+        if (c == L'\'') out += L"''";
+        else out.push_back(c);
+    }
+    return out + L"'";
+}
+
+struct ShellResult {
+    DWORD exitCode{(DWORD)-1};
+    std::vector<std::wstring> output;
+};
+
+class PowerShellHost {
+public:
+    ~PowerShellHost() {
+        {
+            std::lock_guard<std::mutex> g(m_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (process_) TerminateProcess(process_, 0);
+        if (thread_.joinable()) thread_.join();
+        CloseHost();
+    }
+
+    std::future<ShellResult> Submit(const std::wstring& script) {
+        Pending p;
+        p.script = script;
+        std::future<ShellResult> f = p.result.get_future();
+        {
+            std::lock_guard<std::mutex> g(m_);
+            queue_.push_back(std::move(p));
+            if (!thread_.joinable()) thread_ = std::thread([this]() { Loop(); });
+        }
+        cv_.notify_one();
+        return f;
+    }
+
+    ShellResult Run(const std::wstring& script) {
+        TraceScope trace(L"process", L"powershell");
+        trace.Detail(script.substr(0, 120));
+        ShellResult r = Submit(script).get();
+        trace.Result((long long)r.exitCode);
+        return r;
+    }
+
+    std::vector<ShellResult> RunBatch(const std::vector<std::wstring>& scripts) {
+        std::vector<std::future<ShellResult>> futures;
+        for (const auto& s : scripts) futures.push_back(Submit(s));
+        TraceScope trace(L"process", L"powershell-batch");
+        std::vector<ShellResult> results;
+        for (auto& f : futures) results.push_back(f.get());
+        trace.Files(results.size());
+        return results;
+    }
+
+private:
+    struct Pending {
+        std::wstring script;
+        std::promise<ShellResult> result;
+    };
+
+    void Loop() {
+        for (;;) {
+            std::vector<Pending> batch;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                batch.swap(queue_);
+            }
+            size_t next = 0;
+            if (!dead_ && EnsureStarted()) {
+                std::string frames;
+                std::vector<unsigned long long> ids;
+                for (const auto& p : batch) {
+                    unsigned long long id = ++nextId_;
+                    ids.push_back(id);
+                    frames += ToUtf8(Frame(id, p.script));
+                    frames += "\r\n";
+                }
+                if (WritePipe(frames)) {
+                    for (; next < batch.size(); ++next) {
+                        ShellResult r;
+                        if (!ReadFrame(ids[next], r)) break;
+                        batch[next].result.set_value(std::move(r));
+                    }
+                }
+                if (next < batch.size()) {
+                    dead_ = true;
+                    CloseHost();
+                }
+            }
+            for (; next < batch.size(); ++next) {
+                ShellResult r;
+                r.exitCode = RunProcessWait(L"powershell.exe",
+                    L"-NoProfile -NonInteractive -EncodedCommand " + EncodePowerShellScript(batch[next].script), true);
+                batch[next].result.set_value(std::move(r));
+            }
+        }
+    }
+
+    std::wstring Frame(unsigned long long id, const std::wstring& script) const {
+        return L"$global:LASTEXITCODE=0; $zfErr=$Error.Count; "
+               L"try { & ([ScriptBlock]::Create([Text.Encoding]::Unicode.GetString([Convert]::FromBase64String('" +
+               EncodePowerShellScript(script) + L"')))) *>&1 | Out-String -Stream -Width 4096 } catch { }; "
+               L"$zfCode = if ($LASTEXITCODE) { $LASTEXITCODE } elseif ($Error.Count -eq $zfErr) { 0 } else { 1 }; "
+               L"[Console]::Out.WriteLine('" + marker_ + L":" + std::to_wstring(id) + L":' + $zfCode); [Console]::Out.Flush()";
+    }
+
+    bool EnsureStarted() {
+        if (process_) return true;
+        SECURITY_ATTRIBUTES sa{};
+        sa.nLength = sizeof(sa);
+        sa.bInheritHandle = TRUE;
+        HANDLE inRead = nullptr, outWrite = nullptr;
+        if (!CreatePipe(&inRead, &stdinWrite_, &sa, 0)) return false;
+        if (!CreatePipe(&stdoutRead_, &outWrite, &sa, 0)) {
+            CloseHandle(inRead);
+            CloseHost();
+            return false;
+        }
+        SetHandleInformation(stdinWrite_, HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(stdoutRead_, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOW si{};
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = inRead;
+        si.hStdOutput = outWrite;
+        si.hStdError = outWrite;
+        PROCESS_INFORMATION pi{};
+        std::wstring cmd = L"powershell.exe -NoLogo -NoProfile -NonInteractive -ExecutionPolicy Bypass -Command -";
+        BOOL ok = CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi);
+        CloseHandle(inRead);
+        CloseHandle(outWrite);
+        if (!ok) {
+            CloseHost();
+            return false;
+        }
+        CloseHandle(pi.hThread);
+        process_ = pi.hProcess;
+        marker_ = L"<<zf-" + std::to_wstring(pi.dwProcessId) + L"-" + std::to_wstring(GetTickCount64()) + L">>";
+        return WritePipe("[Console]::OutputEncoding=[Text.Encoding]::UTF8; $ProgressPreference='SilentlyContinue'\r\n");
+    }
+
+    void CloseHost() {
+        if (stdinWrite_) { CloseHandle(stdinWrite_); stdinWrite_ = nullptr; }
+        if (stdoutRead_) { CloseHandle(stdoutRead_); stdoutRead_ = nullptr; }
+        if (process_) {
+            TerminateProcess(process_, 1);
+            CloseHandle(process_);
+            process_ = nullptr;
+        }
+        pending_.clear();
+    }
+
+    bool WritePipe(const std::string& data) {
+        size_t off = 0;
+        while (off < data.size()) {
+            DWORD wrote = 0;
+            if (!WriteFile(stdinWrite_, data.data() + off, (DWORD)(data.size() - off), &wrote, nullptr)) return false;
+            off += wrote;
+        }
+        return true;
+    }
+
+    bool ReadLine(std::string& line) {
+        for (;;) {
+            size_t nl = pending_.find('\n');
+            if (nl != std::string::npos) {
+                line = pending_.substr(0, nl);
+                pending_.erase(0, nl + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            char buf[4096];
+            DWORD read = 0;
+            if (!ReadFile(stdoutRead_, buf, sizeof(buf), &read, nullptr) || read == 0) return false;
+            pending_.append(buf, read);
+        }
+    }
+
+    bool ReadFrame(unsigned long long id, ShellResult& r) {
+        std::string prefix = ToUtf8(marker_ + L":" + std::to_wstring(id) + L":");
+        std::string line;
+        while (ReadLine(line)) {
+            if (line.compare(0, prefix.size(), prefix) == 0) {
+                r.exitCode = (DWORD)std::strtol(line.c_str() + prefix.size(), nullptr, 10);
+                return true;
+            }
+            r.output.push_back(FromUtf8(line));
+        }
+        return false;
+    }
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::vector<Pending> queue_;
+    std::thread thread_;
+    bool stopping_{false};
+    bool dead_{false};
+    HANDLE process_{};
+    HANDLE stdinWrite_{};
+    HANDLE stdoutRead_{};
+    std::string pending_;
+    std::wstring marker_;
+    unsigned long long nextId_{0};
+};
+
+static PowerShellHost& DefaultPowerShellHost() {
+    static PowerShellHost host;
+    return host;
+}
+
+static DWORD RunPowerShell(const std::wstring& script) {
+    return DefaultPowerShellHost().Run(script).exitCode;
+}
+
+static std::atomic<bool> g_cancelRequested{false};
+
+struct ProcessSpec {
+    std::wstring app;
+    std::wstring args;
+    DWORD timeoutMs{INFINITE};
+    const std::atomic<bool>* cancel{&g_cancelRequested};
+    std::function<void(const std::wstring&)> onLine;
+};
+
+struct ProcessOutcome {
+    bool started{false};
+    bool timedOut{false};
+    bool cancelled{false};
+    DWORD exitCode{(DWORD)-1};
+};
+
+struct IProcessRunner {
+    virtual ~IProcessRunner() = default;
+    virtual ProcessOutcome Run(const ProcessSpec& spec) = 0;
+};
+
+class OutputLineDecoder {
+public:
+    explicit OutputLineDecoder(const std::function<void(const std::wstring&)>& onLine) : onLine_(onLine) {}
+
+    void Feed(const char* data, size_t size) {
+        bytes_.append(data, size);
+        if (!decided_) {
+            if (bytes_.size() < 2) return;
+            size_t zeros = 0;
+            for (size_t i = 1; i < bytes_.size(); i += 2) zeros += bytes_[i] == 0;
+            utf16_ = zeros * 4 >= bytes_.size();
+            decided_ = true;
+        }
+        size_t usable = utf16_ ? bytes_.size() & ~(size_t)1 : bytes_.size();
+        if (usable == 0) return;
+        std::wstring text;
+        if (utf16_) {
+            for (size_t i = 0; i < usable; i += 2) {
+                text.push_back((wchar_t)((unsigned char)bytes_[i] | ((unsigned char)bytes_[i + 1] << 8)));
+            }
+        } else {
+            int n = MultiByteToWideChar(CP_OEMCP, 0, bytes_.data(), (int)usable, nullptr, 0);
+            text.resize(n > 0 ? n : 0);
+            if (n > 0) MultiByteToWideChar(CP_OEMCP, 0, bytes_.data(), (int)usable, &text[0], n);
+        }
+        bytes_.erase(0, usable);
+        for (wchar_t c : text) {
+            if (c == L'\r' || c == L'\n') {
+                Emit();
+            } else if (c != 0xFEFF) {
+                line_.push_back(c);
+            }
+        }
+    }
+
+    void Finish() { Emit(); }
+
+private:
+    void Emit() {
+        std::wstring t = Trim(line_);
+        line_.clear();
+        if (!t.empty() && onLine_) onLine_(t);
+    }
+
+    std::function<void(const std::wstring&)> onLine_;
+    std::string bytes_;
+    std::wstring line_;
+    bool decided_{false};
+    bool utf16_{false};
+};
+
+static bool ParseProgressPercent(const std::wstring& line, int& percent) {
+    size_t pos = line.rfind(L'%');
+    if (pos == std::wstring::npos || pos == 0) return false;
+    size_t start = pos;
+    while (start > 0 && (iswdigit(line[start - 1]) || line[start - 1] == L'.')) --start;
+    if (start == pos) return false;
+    double v = std::wcstod(line.substr(start, pos - start).c_str(), nullptr);
+    if (v < 0.0 || v > 100.0) return false;
+    percent = (int)v;
+    return true;
+}
+
+class Win32ProcessRunner : public IProcessRunner {
+public:
+    ProcessOutcome Run(const ProcessSpec& spec) override {
+        TraceScope trace(L"process", L"run");
+        if (trace.Active()) trace.Detail(std::filesystem::path(spec.app).filename().wstring() + L" " + spec.args);
+        ProcessOutcome outcome;
+        Pipe out, err;
+        if (!CreateOverlappedPipe(out) || !CreateOverlappedPipe(err)) return outcome;
+
+        std::wstring cmd = L"\"" + spec.app + L"\"" + (spec.args.empty() ? L"" : L" " + spec.args);
+        STARTUPINFOW si{};
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = nullptr;
+        si.hStdOutput = out.child;
+        si.hStdError = err.child;
+        PROCESS_INFORMATION pi{};
+        BOOL created = CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+                                      nullptr, nullptr, &si, &pi);
+        CloseHandle(out.child);
+        out.child = nullptr;
+        CloseHandle(err.child);
+        err.child = nullptr;
+        if (!created) return outcome;
+        CloseHandle(pi.hThread);
+        outcome.started = true;
+
+        OutputLineDecoder outDecoder(spec.onLine), errDecoder(spec.onLine);
+        out.decoder = &outDecoder;
+        err.decoder = &errDecoder;
+        StartRead(out);
+        StartRead(err);
+
+        ULONGLONG startTick = GetTickCount64();
+        bool exited = false;
+        while (out.open || err.open || !exited) {
+            HANDLE waits[3];
+            DWORD count = 0;
+            if (out.open) waits[count++] = out.ov.hEvent;
+            if (err.open) waits[count++] = err.ov.hEvent;
+            if (!exited) waits[count++] = pi.hProcess;
+            WaitForMultipleObjects(count, waits, FALSE, 100);
+
+            if (out.open) PollRead(out);
+            if (err.open) PollRead(err);
+            if (!exited && WaitForSingleObject(pi.hProcess, 0) == WAIT_OBJECT_0) exited = true;
+
+            if (!exited) {
+                if (spec.cancel && spec.cancel->load()) {
+                    outcome.cancelled = true;
+                    TerminateProcess(pi.hProcess, 1);
+                } else if (spec.timeoutMs != INFINITE && GetTickCount64() - startTick >= spec.timeoutMs) {
+                    outcome.timedOut = true;
+                    TerminateProcess(pi.hProcess, 1);
+                }
+            }
+        }
+        outDecoder.Finish();
+        errDecoder.Finish();
+        GetExitCodeProcess(pi.hProcess, &outcome.exitCode);
+        CloseHandle(pi.hProcess);
+        trace.Result((long long)outcome.exitCode);
+        return outcome;
+    }
+
+private:
+    struct Pipe {
+        HANDLE read{};
+        HANDLE child{};
+        OVERLAPPED ov{};
+        char buf[8192];
+        bool open{false};
+        OutputLineDecoder* decoder{};
+        ~Pipe() {
+            if (read) {
+                if (open) {
+                    CancelIoEx(read, &ov);
+                    DWORD n = 0;
+                    GetOverlappedResult(read, &ov, &n, TRUE);
+                }
+                CloseHandle(read);
+            }
+            if (child) CloseHandle(child);
+            if (ov.hEvent) CloseHandle(ov.hEvent);
+        }
+    };
+
+    static bool CreateOverlappedPipe(Pipe& p) {
+        static std::atomic<unsigned> counter{0};
+        std::wstring name = L"\\\\.\\pipe\\zenithfixer-" + std::to_wstring(GetCurrentProcessId()) + L"-" +
+                            std::to_wstring(++counter);
+        p.read = CreateNamedPipeW(name.c_str(), PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                  PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                  1, 0, 64 * 1024, 0, nullptr);
+        if (p.read == INVALID_HANDLE_VALUE) {
+            p.read = nullptr;
+            return false;
+        }
+        SECURITY_ATTRIBUTES sa{};
+        sa.nLength = sizeof(sa);
+        sa.bInheritHandle = TRUE;
+        p.child = CreateFileW(name.c_str(), GENERIC_WRITE, 0, &sa, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (p.child == INVALID_HANDLE_VALUE) {
+            p.child = nullptr;
+            return false;
+        }
+        p.ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        return p.ov.hEvent != nullptr;
+    }
+
+    static void StartRead(Pipe& p) {
+        for (;;) {
+            ResetEvent(p.ov.hEvent);
+            DWORD n = 0;
+            if (ReadFile(p.read, p.buf, sizeof(p.buf), &n, &p.ov)) {
+                if (n > 0) p.decoder->Feed(p.buf, n);
+                continue;
+            }
+            p.open = GetLastError() == ERROR_IO_PENDING;
+            return;
+        }
+    }
+
+    static void PollRead(Pipe& p) {
+        DWORD n = 0;
+        if (GetOverlappedResult(p.read, &p.ov, &n, FALSE)) {
+            if (n > 0) p.decoder->Feed(p.buf, n);
+            StartRead(p);
+        } else if (GetLastError() != ERROR_IO_INCOMPLETE) {
+            p.open = false;
+        }
+    }
+};
+
+static IProcessRunner& DefaultProcessRunner() {
+    static Win32ProcessRunner runner;
+    return runner;
+}
+
+static std::wstring SystemToolPath(const std::wstring& exe) {
+    wchar_t dir[MAX_PATH];
+    BOOL wow64 = FALSE;
+    if (IsWow64Process(GetCurrentProcess(), &wow64) && wow64 && GetWindowsDirectoryW(dir, MAX_PATH)) {
+        return (std::filesystem::path(dir) / L"Sysnative" / exe).wstring();
+    }
+    if (GetSystemDirectoryW(dir, MAX_PATH)) return (std::filesystem::path(dir) / exe).wstring();
+    return exe;
+}
+
+static DWORD RunSystemTool(HWND log, const std::wstring& label, const std::wstring& exe, const std::wstring& args,
+                           DWORD timeoutMs, const std::function<void(int)>& report) {
+    int lastLogged = -1;
+    ProcessSpec spec;
+    spec.app = SystemToolPath(exe);
+    spec.args = args;
+    spec.timeoutMs = timeoutMs;
+    spec.onLine = [&](const std::wstring& line) {
+        int pct = 0;
+        if (ParseProgressPercent(line, pct)) {
+            if (report) report(pct);
+            if (pct / 5 != lastLogged / 5) {
+                lastLogged = pct;
+                AppendLog(log, L"  " + label + L": " + std::to_wstring(pct) + L"%");
+            }
+            return;
+        }
+        AppendLog(log, L"  " + line);
+    };
+    ProcessOutcome r = DefaultProcessRunner().Run(spec);
+    if (!r.started) {
+        AppendLog(log, L" Could not start " + exe + L"; retrying through PowerShell.");
+        return RunPowerShell(exe + L" " + args);
+    }
+    if (r.timedOut) AppendLog(log, L" " + label + L" timed out and was stopped.");
+    if (r.cancelled) AppendLog(log, L" " + label + L" was cancelled.");
+    return r.exitCode;
+}
+
+class BcryptHash {
+public:
+    BcryptHash(LPCWSTR algorithm, ULONG digestSize) : digestSize_(digestSize) {
+        if (BCryptOpenAlgorithmProvider(&alg_, algorithm, nullptr, 0) != 0) alg_ = nullptr;
+        if (alg_ && BCryptCreateHash(alg_, &hash_, nullptr, 0, nullptr, 0, 0) != 0) hash_ = nullptr;
+    }
+    ~BcryptHash() {
+        if (hash_) BCryptDestroyHash(hash_);
+        if (alg_) BCryptCloseAlgorithmProvider(alg_, 0);
+    }
+    BcryptHash(const BcryptHash&) = delete;
+    BcryptHash& operator=(const BcryptHash&) = delete;
+
+    bool Update(const void* data, size_t size) {
+        if (!hash_) return false;
+        return BCryptHashData(hash_, (PUCHAR)data, (ULONG)size, 0) == 0;
+    }
+
+    std::wstring FinishHex() {
+        unsigned char digest[64];
+        if (!hash_ || digestSize_ > sizeof(digest) || BCryptFinishHash(hash_, digest, digestSize_, 0) != 0) return L"";
+        static const wchar_t* hex = L"0123456789abcdef";
+        std::wstring out;
+        out.reserve(digestSize_ * 2);
+        for (ULONG i = 0; i < digestSize_; ++i) {
+            out.push_back(hex[digest[i] >> 4]);
+            out.push_back(hex[digest[i] & 15]);
+        }
+        return out;
+    }
+
+private:
+    BCRYPT_ALG_HANDLE alg_{};
+    BCRYPT_HASH_HANDLE hash_{};
+    ULONG digestSize_;
+};
+
+class Sha256 : public BcryptHash {
+public:
+    Sha256() : BcryptHash(BCRYPT_SHA256_ALGORITHM, 32) {}
+};
+
+// Roblox's per-file deployment manifest lists MD5 digests.
+class Md5 : public BcryptHash {
+public:
+    Md5() : BcryptHash(BCRYPT_MD5_ALGORITHM, 16) {}
+};
+
+class Xxh64 {
+public:
+    explicit Xxh64(unsigned long long seed = 0) {
+        v_[0] = seed + kP1 + kP2;
+        v_[1] = seed + kP2;
+        v_[2] = seed;
+        v_[3] = seed - kP1;
+        seed_ = seed;
+    }
+
+    void Update(const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        const unsigned char* end = p + size;
+        total_ += size;
+        if (used_ + size < 32) {
+            memcpy(buf_ + used_, p, size);
+            used_ += size;
+            return;
+        }
+        if (used_) {
+            size_t fill = 32 - used_;
+            memcpy(buf_ + used_, p, fill);
+            Stripe(buf_);
+            p += fill;
+            used_ = 0;
+        }
+        for (; p + 32 <= end; p += 32) Stripe(p);
+        used_ = (size_t)(end - p);
+        memcpy(buf_, p, used_);
+    }
+
+    unsigned long long Digest() const {
+        unsigned long long h;
+        if (total_ >= 32) {
+            h = Rotl(v_[0], 1) + Rotl(v_[1], 7) + Rotl(v_[2], 12) + Rotl(v_[3], 18);
+            for (unsigned long long v : v_) h = (h ^ Round(0, v)) * kP1 + kP4;
+        } else {
+            h = seed_ + kP5;
+        }
+        h += total_;
+        const unsigned char* p = buf_;
+        const unsigned char* end = buf_ + used_;
+        for (; p + 8 <= end; p += 8) h = Rotl(h ^ Round(0, Read64(p)), 27) * kP1 + kP4;
+        if (p + 4 <= end) {
+            h = Rotl(h ^ (Read32(p) * kP1), 23) * kP2 + kP3;
+            p += 4;
+        }
+        for (; p < end; ++p) h = Rotl(h ^ (*p * kP5), 11) * kP1;
+        h ^= h >> 33;
+        h *= kP2;
+        h ^= h >> 29;
+        h *= kP3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    std::wstring DigestHex() const {
+        wchar_t hex[17];
+        swprintf(hex, 17, L"%016llx", Digest());
+        return hex;
+    }
+
+private:
+    static constexpr unsigned long long kP1 = 11400714785074694791ull;
+    static constexpr unsigned long long kP2 = 14029467366897019727ull;
+    static constexpr unsigned long long kP3 = 1609587929392839161ull;
+    static constexpr unsigned long long kP4 = 9650029242287828579ull;
+    static constexpr unsigned long long kP5 = 2870177450012600261ull;
+
+    static unsigned long long Rotl(unsigned long long x, int r) { return (x << r) | (x >> (64 - r)); }
+    static unsigned long long Round(unsigned long long acc, unsigned long long input) { return Rotl(acc + input * kP2, 31) * kP1; }
+    static unsigned long long Read64(const unsigned char* p) {
+        unsigned long long v;
+        memcpy(&v, p, 8);
+        return v;
+    }
+    static unsigned long long Read32(const unsigned char* p) {
+        unsigned v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    void Stripe(const unsigned char* p) {
+        for (int i = 0; i < 4; ++i) v_[i] = Round(v_[i], Read64(p + 8 * i));
+    }
+
+    unsigned long long v_[4];
+    unsigned long long seed_{0};
+    unsigned long long total_{0};
+    unsigned char buf_[32];
+    size_t used_{0};
+};
+
+static std::wstring Sha256File(const std::filesystem::path& path) {
+    HANDLE f = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return L"";
+    Sha256 sha;
+    std::vector<char> buf(1024 * 1024);
+    bool ok = true;
+    for (;;) {
+        DWORD read = 0;
+        if (!ReadFile(f, buf.data(), (DWORD)buf.size(), &read, nullptr)) { ok = false; break; }
+        if (read == 0) break;
+        if (!sha.Update(buf.data(), read)) { ok = false; break; }
+    }
+    CloseHandle(f);
+    return ok ? sha.FinishHex() : L"";
+}
+
+struct HttpRequest {
+    std::wstring method{L"GET"};
+    std::wstring url;
+    std::vector<std::wstring> headers;
+};
+
+struct HttpResponse {
+    DWORD status{0};
+    unsigned long long contentLength{0};
+    bool hasContentLength{false};
+    unsigned long long totalSize{0};
+    bool hasTotalSize{false};
+    bool acceptRanges{false};
+    std::wstring etag;
+    std::wstring lastModified;
+};
+
+struct IHttpTransport {
+    virtual ~IHttpTransport() = default;
+    virtual bool Request(const HttpRequest& req, HttpResponse& resp,
+                         const std::function<bool(const char*, size_t)>& body) = 0;
+};
+
+struct WinHttpHandle {
+    HINTERNET h{};
+    WinHttpHandle() = default;
+    explicit WinHttpHandle(HINTERNET v) : h(v) {}
+    ~WinHttpHandle() { if (h) WinHttpCloseHandle(h); }
+    WinHttpHandle(const WinHttpHandle&) = delete;
+    WinHttpHandle& operator=(const WinHttpHandle&) = delete;
+    operator HINTERNET() const { return h; }
+};
+
+static std::wstring QueryHttpHeader(HINTERNET req, DWORD query) {
+    DWORD size = 0;
+    WinHttpQueryHeaders(req, query, WINHTTP_HEADER_NAME_BY_INDEX, WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || size == 0) return L"";
+    std::wstring v(size / sizeof(wchar_t), L'\0');
+    if (!WinHttpQueryHeaders(req, query, WINHTTP_HEADER_NAME_BY_INDEX, &v[0], &size, WINHTTP_NO_HEADER_INDEX)) return L"";
+    v.resize(size / sizeof(wchar_t));
+    return v;
+}
+
+class WinHttpTransport : public IHttpTransport {
+public:
+    WinHttpTransport() {
+        session_.h = WinHttpOpen(L"ZenithFixer/1.0", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY,
+                                 WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+        if (session_) {
+            WinHttpSetTimeouts(session_, 10000, 15000, 30000, 60000);
+        }
+    }
+
+    bool Request(const HttpRequest& req, HttpResponse& resp,
+                 const std::function<bool(const char*, size_t)>& body) override {
+        if (!session_) return false;
+        URL_COMPONENTS uc{};
+        uc.dwStructSize = sizeof(uc);
+        uc.dwSchemeLength = (DWORD)-1;
+        uc.dwHostNameLength = (DWORD)-1;
+        uc.dwUrlPathLength = (DWORD)-1;
+        uc.dwExtraInfoLength = (DWORD)-1;
+        if (!WinHttpCrackUrl(req.url.c_str(), (DWORD)req.url.size(), 0, &uc)) return false;
+        std::wstring host(uc.lpszHostName, uc.dwHostNameLength);
+        std::wstring path(uc.lpszUrlPath, uc.dwUrlPathLength);
+        if (uc.lpszExtraInfo) path.append(uc.lpszExtraInfo, uc.dwExtraInfoLength);
+        if (path.empty()) path = L"/";
+
+        WinHttpHandle conn(WinHttpConnect(session_, host.c_str(), uc.nPort, 0));
+        if (!conn) return false;
+        WinHttpHandle request(WinHttpOpenRequest(conn, req.method.c_str(), path.c_str(), nullptr,
+                                                 WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                                 uc.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0));
+        if (!request) return false;
+        for (const auto& h : req.headers) {
+            WinHttpAddRequestHeaders(request, h.c_str(), (DWORD)-1L, WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_REPLACE);
+        }
+        if (!WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0, 0, 0)) return false;
+        if (!WinHttpReceiveResponse(request, nullptr)) return false;
+
+        DWORD status = 0, size = sizeof(status);
+        WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                            WINHTTP_HEADER_NAME_BY_INDEX, &status, &size, WINHTTP_NO_HEADER_INDEX);
+        resp.status = status;
+        std::wstring len = QueryHttpHeader(request, WINHTTP_QUERY_CONTENT_LENGTH);
+        if (!len.empty()) {
+            resp.contentLength = std::wcstoull(len.c_str(), nullptr, 10);
+            resp.hasContentLength = true;
+        }
+        std::wstring range = QueryHttpHeader(request, WINHTTP_QUERY_CONTENT_RANGE);
+        size_t slash = range.rfind(L'/');
+        if (slash != std::wstring::npos && range.compare(slash + 1, std::wstring::npos, L"*") != 0) {
+            resp.totalSize = std::wcstoull(range.c_str() + slash + 1, nullptr, 10);
+            resp.hasTotalSize = true;
+        } else if (status == 200 && resp.hasContentLength) {
+            resp.totalSize = resp.contentLength;
+            resp.hasTotalSize = true;
+        }
+        resp.acceptRanges = ContainsCaseInsensitive(QueryHttpHeader(request, WINHTTP_QUERY_ACCEPT_RANGES), L"bytes") ||
+                            status == 206;
+        resp.etag = QueryHttpHeader(request, WINHTTP_QUERY_ETAG);
+        resp.lastModified = QueryHttpHeader(request, WINHTTP_QUERY_LAST_MODIFIED);
+
+        if (status >= 400) return false;
+        if (req.method == L"HEAD" || !body || status == 304) return true;
+
+        std::vector<char> buf(256 * 1024);
+        for (;;) {
+            DWORD read = 0;
+            if (!WinHttpReadData(request, buf.data(), (DWORD)buf.size(), &read)) return false;
+            if (read == 0) break;
+            if (!body(buf.data(), read)) return false;
+        }
+        return true;
+    }
+
+private:
+    WinHttpHandle session_;
+};
+
+static IHttpTransport& DefaultHttpTransport() {
+    static WinHttpTransport transport;
+    return transport;
+}
+
+struct DownloadChunk {
+    unsigned long long start{0};
+    unsigned long long end{0};
+    unsigned long long written{0};
+};
+
+static bool LoadDownloadState(const std::filesystem::path& meta, const HttpResponse& info,
+                              std::vector<DownloadChunk>& chunks) {
+    std::ifstream in(meta);
+    if (!in) return false;
+    std::string magic, size, etag, lastModified;
+    if (!std::getline(in, magic) || magic != "zfdl1") return false;
+    if (!std::getline(in, size) || !std::getline(in, etag) || !std::getline(in, lastModified)) return false;
+    if (std::strtoull(size.c_str(), nullptr, 10) != info.totalSize) return false;
+    if (FromUtf8(etag) != info.etag || FromUtf8(lastModified) != info.lastModified) return false;
+    if (info.etag.empty() && info.lastModified.empty()) return false;
+    std::vector<DownloadChunk> loaded;
+    DownloadChunk c;
+    while (in >> c.start >> c.end >> c.written) {
+        if (c.end < c.start || c.written > c.end - c.start) return false;
+        loaded.push_back(c);
+    }
+    if (loaded.empty()) return false;
+    chunks = loaded;
+    return true;
+}
+
+static void SaveDownloadState(const std::filesystem::path& meta, const HttpResponse& info,
+                              const std::vector<DownloadChunk>& chunks) {
+    std::ofstream out(meta, std::ios::trunc);
+    out << "zfdl1\n" << info.totalSize << "\n" << ToUtf8(info.etag) << "\n" << ToUtf8(info.lastModified) << "\n";
+    for (const auto& c : chunks) out << c.start << " " << c.end << " " << c.written << "\n";
+}
+
+static bool WriteAt(HANDLE file, unsigned long long offset, const char* data, size_t size) {
+    while (size > 0) {
+        OVERLAPPED ov{};
+        ov.Offset = (DWORD)(offset & 0xFFFFFFFFull);
+        ov.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD wrote = 0;
+        DWORD want = (DWORD)(std::min)(size, (size_t)(1u << 30));
+        if (!WriteFile(file, data, want, &wrote, &ov) || wrote == 0) return false;
+        offset += wrote;
+        data += wrote;
+        size -= wrote;
+    }
+    return true;
+}
+
+static bool DownloadWithHttp(IHttpTransport& http, const std::wstring& url, const std::filesystem::path& dest,
+                             HWND log, const std::function<void(unsigned long long, unsigned long long)>& progress,
+                             HttpResponse* served = nullptr) {
+    TraceScope trace(L"download", L"http");
+    if (trace.Active()) trace.Detail(url);
+    const unsigned long long kMinRangedSize = 8ull * 1024 * 1024;
+    const unsigned long long kMinChunkSize = 4ull * 1024 * 1024;
+    const size_t kMaxChunks = 4;
+
+    HttpRequest probe;
+    probe.method = L"HEAD";
+    probe.url = url;
+    HttpResponse info;
+    if (!http.Request(probe, info, nullptr)) {
+        info = HttpResponse();
+    }
+    if (served) *served = info;
+    bool ranged = info.acceptRanges && info.hasTotalSize && info.totalSize >= kMinRangedSize;
+
+    std::filesystem::path part = dest;
+    part += L".part";
+    std::filesystem::path meta = dest;
+    meta += L".part.meta";
+    std::error_code ec;
+
+    std::vector<DownloadChunk> chunks;
+    bool resumed = ranged && std::filesystem::exists(part, ec) && LoadDownloadState(meta, info, chunks);
+    if (!resumed) {
+        chunks.clear();
+        if (ranged) {
+            size_t count = (size_t)(std::min)((unsigned long long)kMaxChunks, info.totalSize / kMinChunkSize);
+            count = (std::max)(count, (size_t)1);
+            unsigned long long step = info.totalSize / count;
+            for (size_t i = 0; i < count; ++i) {
+                DownloadChunk c;
+                c.start = i * step;
+                c.end = (i + 1 == count) ? info.totalSize : (i + 1) * step;
+                chunks.push_back(c);
+            }
+        } else {
+            DownloadChunk c;
+            c.end = info.hasTotalSize ? info.totalSize : 0;
+            chunks.push_back(c);
+        }
+        std::filesystem::remove(part, ec);
+        std::filesystem::remove(meta, ec);
+    }
+
+    HANDLE file = CreateFileW(part.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              resumed ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    if (info.hasTotalSize) {
+        LARGE_INTEGER li{};
+        li.QuadPart = (LONGLONG)info.totalSize;
+        if (SetFilePointerEx(file, li, nullptr, FILE_BEGIN)) SetEndOfFile(file);
+    }
+
+    unsigned long long total = info.hasTotalSize ? info.totalSize : 0;
+    unsigned long long done = 0;
+    for (const auto& c : chunks) done += c.written;
+    if (resumed && log) {
+        AppendLog(log, L" Resuming download at " + FormatBytes(done) + L" of " + FormatBytes(total) + L".");
+    }
+
+    std::mutex m;
+    unsigned long long sinceSave = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+    auto onBytes = [&](DownloadChunk& c, size_t n) {
+        std::lock_guard<std::mutex> g(m);
+        c.written += n;
+        done += n;
+        sinceSave += n;
+        if (ranged && sinceSave >= 8ull * 1024 * 1024) {
+            sinceSave = 0;
+            SaveDownloadState(meta, info, chunks);
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (progress && now - lastReport >= std::chrono::milliseconds(250)) {
+            lastReport = now;
+            progress(done, total);
+        }
+    };
+
+    auto fetchChunk = [&](DownloadChunk& c) -> bool {
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            unsigned long long remaining = c.end - c.start - c.written;
+            if (info.hasTotalSize && remaining == 0) return true;
+            HttpRequest rq;
+            rq.url = url;
+            if (ranged) {
+                rq.headers.push_back(L"Range: bytes=" + std::to_wstring(c.start + c.written) + L"-" + std::to_wstring(c.end - 1));
+                if (!info.etag.empty()) rq.headers.push_back(L"If-Range: " + info.etag);
+            } else if (c.written > 0) {
+                std::lock_guard<std::mutex> g(m);
+                done -= c.written;
+                c.written = 0;
+            }
+            HttpResponse rs;
+            bool ok = http.Request(rq, rs, [&](const char* data, size_t n) {
+                if (ranged && rs.status != 206) return false;
+                if (info.hasTotalSize && n > c.end - c.start - c.written) return false;
+                if (!WriteAt(file, c.start + c.written, data, n)) return false;
+                onBytes(c, n);
+                return true;
+            });
+            if (ok && !info.hasTotalSize) {
+                std::lock_guard<std::mutex> g(m);
+                c.end = c.start + c.written;
+                total = c.written;
+                return true;
+            }
+            if (ok && c.written == c.end - c.start) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(500 << attempt));
+        }
+        return false;
+    };
+
+    std::vector<char> results(chunks.size(), 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        workers.emplace_back([&, i]() { results[i] = fetchChunk(chunks[i]) ? 1 : 0; });
+    }
+    results[0] = fetchChunk(chunks[0]) ? 1 : 0;
+    for (auto& t : workers) t.join();
+
+    bool ok = std::all_of(results.begin(), results.end(), [](char r) { return r != 0; });
+    LARGE_INTEGER actual{};
+    if (ok && (!GetFileSizeEx(file, &actual) || (unsigned long long)actual.QuadPart != total)) {
+        AppendLog(log, L" Downloaded size does not match the server's Content-Length.");
+        ok = false;
+    }
+    if (!ok && ranged) SaveDownloadState(meta, info, chunks);
+    CloseHandle(file);
+    if (!ok) return false;
+
+    if (progress) progress(total, total);
+    std::filesystem::remove(meta, ec);
+    if (!MoveFileExW(part.wstring().c_str(), dest.wstring().c_str(), MOVEFILE_REPLACE_EXISTING)) return false;
+    trace.Bytes(total);
+    trace.Files(1);
+    trace.Result(1);
+    return true;
+}
+
+struct ArtifactCacheEntry {
+    std::wstring etag;
+    std::wstring lastModified;
+    std::wstring sha256;
+    unsigned long long size{0};
+    long long lastUsed{0};
+};
+
+class ArtifactCache {
+public:
+    ArtifactCache(std::filesystem::path root, unsigned long long maxBytes)
+        : root_(std::move(root)), maxBytes_(maxBytes) {
+        std::error_code ec;
+        std::filesystem::create_directories(root_ / L"blobs", ec);
+        Load();
+    }
+
+    bool Fetch(IHttpTransport& http, const std::wstring& url, const std::filesystem::path& dest, HWND log,
+               const std::function<void(unsigned long long, unsigned long long)>& progress) {
+        ArtifactCacheEntry cached;
+        bool known = false;
+        {
+            std::lock_guard<std::mutex> g(m_);
+            auto it = entries_.find(url);
+            if (it != entries_.end()) {
+                cached = it->second;
+                known = true;
+            }
+        }
+
+        if (known && IsBlobIntact(cached)) {
+            HttpRequest check;
+            check.method = L"HEAD";
+            check.url = url;
+            if (!cached.etag.empty()) check.headers.push_back(L"If-None-Match: " + cached.etag);
+            if (!cached.lastModified.empty()) check.headers.push_back(L"If-Modified-Since: " + cached.lastModified);
+            HttpResponse rs;
+            bool reached = http.Request(check, rs, nullptr);
+            bool fresh = rs.status == 304 ||
+                         (rs.status == 200 && ((!cached.etag.empty() && rs.etag == cached.etag) ||
+                                               (!cached.lastModified.empty() && rs.lastModified == cached.lastModified)));
+            if (!reached && rs.status == 0) {
+                AppendLog(log, L" Server unreachable; using cached " + dest.filename().wstring() + L".");
+                fresh = true;
+            }
+            if (fresh && PlaceBlob(cached.sha256, dest)) {
+                std::lock_guard<std::mutex> g(m_);
+                auto& e = entries_[url];
+                e.lastUsed = Now();
+                ++hits_;
+                bytesSaved_ += e.size;
+                Save();
+                AppendLog(log, L" Cache hit for " + dest.filename().wstring() + L" (" + FormatBytes(cached.size) + L").");
+                if (progress) progress(cached.size, cached.size);
+                return true;
+            }
+        }
+
+        std::filesystem::path staging = root_ / L"blobs" / (L"incoming-" + std::to_wstring(std::hash<std::wstring>()(url)));
+        HttpResponse served;
+        if (!DownloadWithHttp(http, url, staging, log, progress, &served)) return false;
+        std::wstring sha = Sha256File(staging);
+        std::error_code ec;
+        unsigned long long size = std::filesystem::file_size(staging, ec);
+        if (sha.empty() || ec) {
+            std::filesystem::remove(staging, ec);
+            return false;
+        }
+        std::filesystem::path blob = BlobPath(sha);
+        if (std::filesystem::exists(blob, ec)) {
+            std::filesystem::remove(staging, ec);
+        } else if (!MoveFileExW(staging.wstring().c_str(), blob.wstring().c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            std::filesystem::remove(staging, ec);
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> g(m_);
+            ArtifactCacheEntry e;
+            e.etag = served.etag;
+            e.lastModified = served.lastModified;
+            e.sha256 = sha;
+            e.size = size;
+            e.lastUsed = Now();
+            entries_[url] = e;
+            ++misses_;
+            Evict(url);
+            Save();
+        }
+        return PlaceBlob(sha, dest);
+    }
+
+    std::wstring StatsLine() {
+        std::lock_guard<std::mutex> g(m_);
+        unsigned long long lookups = hits_ + misses_;
+        unsigned long long stored = 0;
+        for (const auto& kv : entries_) stored += kv.second.size;
+        int rate = lookups ? (int)(hits_ * 100 / lookups) : 0;
+        return L"Artifact cache: " + std::to_wstring(hits_) + L"/" + std::to_wstring(lookups) + L" hits (" +
+               std::to_wstring(rate) + L"%), " + FormatBytes(bytesSaved_) + L" saved, " +
+               std::to_wstring(entries_.size()) + L" entries using " + FormatBytes(stored) + L".";
+    }
+
+private:
+    static long long Now() {
+        return (long long)std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::filesystem::path BlobPath(const std::wstring& sha) const {
+        return root_ / L"blobs" / sha;
+    }
+
+    bool IsBlobIntact(const ArtifactCacheEntry& e) const {
+        std::error_code ec;
+        std::filesystem::path blob = BlobPath(e.sha256);
+        if (std::filesystem::file_size(blob, ec) != e.size || ec) return false;
+        return Sha256File(blob) == e.sha256;
+    }
+
+    bool PlaceBlob(const std::wstring& sha, const std::filesystem::path& dest) const {
+        std::error_code ec;
+        std::filesystem::remove(dest, ec);
+        std::filesystem::path blob = BlobPath(sha);
+        if (CreateHardLinkW(dest.wstring().c_str(), blob.wstring().c_str(), nullptr)) return true;
+        return CopyFileW(blob.wstring().c_str(), dest.wstring().c_str(), FALSE) != 0;
+    }
+
+    void Evict(const std::wstring& keep) {
+        unsigned long long total = 0;
+        for (const auto& kv : entries_) total += kv.second.size;
+        while (total > maxBytes_) {
+            auto victim = entries_.end();
+            for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                if (it->first == keep) continue;
+                if (victim == entries_.end() || it->second.lastUsed < victim->second.lastUsed) victim = it;
+            }
+            if (victim == entries_.end()) break;
+            total -= victim->second.size;
+            std::wstring sha = victim->second.sha256;
+            entries_.erase(victim);
+            bool shared = false;
+            for (const auto& kv : entries_) shared = shared || kv.second.sha256 == sha;
+            std::error_code ec;
+            if (!shared) std::filesystem::remove(BlobPath(sha), ec);
+        }
+    }
+
+    void Load() {
+        std::ifstream in(root_ / L"index.txt");
+        std::string line;
+        if (!std::getline(in, line)) return;
+        {
+            std::istringstream header(line);
+            std::string magic;
+            header >> magic >> hits_ >> misses_ >> bytesSaved_;
+            if (magic != "zfac1") {
+                hits_ = misses_ = bytesSaved_ = 0;
+                return;
+            }
+        }
+        while (std::getline(in, line)) {
+            std::vector<std::string> f;
+            size_t pos = 0;
+            for (;;) {
+                size_t tab = line.find('\t', pos);
+                f.push_back(line.substr(pos, tab == std::string::npos ? std::string::npos : tab - pos));
+                if (tab == std::string::npos) break;
+                pos = tab + 1;
+            }
+            if (f.size() != 6) continue;
+            ArtifactCacheEntry e;
+            e.etag = FromUtf8(f[1]);
+            e.lastModified = FromUtf8(f[2]);
+            e.sha256 = FromUtf8(f[3]);
+            e.size = std::strtoull(f[4].c_str(), nullptr, 10);
+            e.lastUsed = std::strtoll(f[5].c_str(), nullptr, 10);
+            entries_[FromUtf8(f[0])] = e;
+        }
+    }
+
+    void Save() const {
+        std::filesystem::path tmp = root_ / L"index.txt.tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            out << "zfac1 " << hits_ << " " << misses_ << " " << bytesSaved_ << "\n";
+            for (const auto& kv : entries_) {
+                const auto& e = kv.second;
+                out << ToUtf8(kv.first) << "\t" << ToUtf8(e.etag) << "\t" << ToUtf8(e.lastModified) << "\t"
+                    << ToUtf8(e.sha256) << "\t" << e.size << "\t" << e.lastUsed << "\n";
+            }
+        }
+        MoveFileExW(tmp.wstring().c_str(), (root_ / L"index.txt").wstring().c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+
+    std::filesystem::path root_;
+    unsigned long long maxBytes_;
+    std::mutex m_;
+    std::map<std::wstring, ArtifactCacheEntry> entries_;
+    unsigned long long hits_{0};
+    unsigned long long misses_{0};
+    unsigned long long bytesSaved_{0};
+};
+
+static ArtifactCache& DefaultArtifactCache() {
+    static ArtifactCache cache(GetBackupRoot() / L"ArtifactCache", 512ull * 1024 * 1024);
+    return cache;
+}
+
+static bool DownloadWithInvokeWebRequest(const std::wstring& url, const std::wstring& dest, HWND log = nullptr) {
+    std::wstring script = L"Invoke-WebRequest -Uri " + PsQuote(url) + L" -OutFile " + PsQuote(dest) + L" -UseBasicParsing";
+    AppendLog(log, L" PowerShell: " + script);
+    DWORD code = RunPowerShell(script);
+    return code == 0;
+}
+
+static bool DownloadFile(const std::wstring& url, const std::filesystem::path& dest, HWND log,
+                         const std::function<void(int)>& report = {}) {
+    int lastLogged = -1;
+    bool ok = DefaultArtifactCache().Fetch(DefaultHttpTransport(), url, dest, log,
+        [&](unsigned long long done, unsigned long long total) {
+            if (total == 0) return;
+            int pct = (int)(done * 100 / total);
+            if (report) report(pct);
+            if (pct / 10 != lastLogged / 10 && log) {
+                lastLogged = pct;
+                AppendLog(log, L"  " + dest.filename().wstring() + L": " + FormatBytes(done) + L" / " +
+                               FormatBytes(total) + L" (" + std::to_wstring(pct) + L"%)");
+            }
+        });
+    if (ok) return true;
+    AppendLog(log, L" Native download failed; falling back to PowerShell...");
+    return DownloadWithInvokeWebRequest(url, dest.wstring(), log);
+}
+
+static void CloseRobloxBrowserTabs(HWND log) {
+    AppendLog(log, L"Attempting to close Roblox browser tabs/windows...");
+    RunPowerShell(L"$p=Get-Process; "
+                  L"$w=$p | Where-Object { $_.MainWindowTitle -like '*Roblox*' }; "
+                  L"$w | ForEach-Object { $_.CloseMainWindow() | Out-Null }");
+}
+
+struct HealthProbe {
+    bool healthy{false};
+    std::wstring detail;
+    long long checkedAt{0};
+};
+
+static long long UnixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+class HealthProbeCache {
+public:
+    explicit HealthProbeCache(std::filesystem::path file) : file_(std::move(file)) {}
+
+    HealthProbe Get(const std::wstring& id, long long maxAgeSeconds, const std::function<HealthProbe()>& probe) {
+        {
+            std::lock_guard<std::mutex> g(m_);
+            Load();
+            auto it = entries_.find(id);
+            if (it != entries_.end() && it->second.healthy && UnixNow() - it->second.checkedAt < maxAgeSeconds) return it->second;
+        }
+        HealthProbe result = probe();
+        result.checkedAt = UnixNow();
+        std::lock_guard<std::mutex> g(m_);
+        entries_[id] = result;
+        Save();
+        return result;
+    }
+
+    void Record(const std::wstring& id, bool healthy, const std::wstring& detail) {
+        std::lock_guard<std::mutex> g(m_);
+        Load();
+        entries_[id] = HealthProbe{ healthy, detail, UnixNow() };
+        Save();
+    }
+
+    void Invalidate(const std::wstring& id) {
+        std::lock_guard<std::mutex> g(m_);
+        Load();
+        entries_.erase(id);
+        Save();
+    }
+
+private:
+    void Load() {
+        if (loaded_) return;
+        loaded_ = true;
+        std::ifstream in(file_);
+        std::string line;
+        if (!std::getline(in, line) || line != "zfhp1") return;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string id, healthy, checked, detail;
+            if (!std::getline(fields, id, '\t') || !std::getline(fields, healthy, '\t') || !std::getline(fields, checked, '\t')) continue;
+            std::getline(fields, detail);
+            entries_[FromUtf8(id)] = HealthProbe{ healthy == "1", FromUtf8(detail), std::atoll(checked.c_str()) };
+        }
+    }
+
+    void Save() {
+        std::filesystem::path tmp = file_;
+        tmp += L".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out << "zfhp1\n";
+            for (const auto& [id, p] : entries_) {
+                out << ToUtf8(id) << '\t' << (p.healthy ? "1" : "0") << '\t' << p.checkedAt << '\t' << ToUtf8(p.detail) << '\n';
+            }
+            if (!out) return;
+        }
+        MoveFileExW(tmp.wstring().c_str(), file_.wstring().c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+
+    std::filesystem::path file_;
+    std::mutex m_;
+    std::map<std::wstring, HealthProbe> entries_;
+    bool loaded_{false};
+};
+
+static HealthProbeCache& DefaultHealthProbes() {
+    static HealthProbeCache cache(GetBackupRoot() / L"Health.cache");
+    return cache;
+}
+
+static bool ReadRegistryString(HKEY root, const wchar_t* subkey, const wchar_t* value, DWORD viewFlag, std::wstring& out) {
+    wchar_t buf[256];
+    DWORD size = sizeof(buf);
+    if (RegGetValueW(root, subkey, value, RRF_RT_REG_SZ | viewFlag, nullptr, buf, &size) != ERROR_SUCCESS) return false;
+    out = buf;
+    return true;
+}
+
+static bool ReadRegistryDword(HKEY root, const wchar_t* subkey, const wchar_t* value, DWORD viewFlag, DWORD& out) {
+    DWORD size = sizeof(out);
+    return RegGetValueW(root, subkey, value, RRF_RT_REG_DWORD | viewFlag, nullptr, &out, &size) == ERROR_SUCCESS;
+}
+
+static HealthProbe ProbeVcRuntime() {
+    const wchar_t* key = L"SOFTWARE\\Microsoft\\VisualStudio\\14.0\\VC\\Runtimes\\x64";
+    const DWORD kMinMinor = 30;
+    HealthProbe p;
+    DWORD installed = 0, major = 0, minor = 0, build = 0;
+    if (!ReadRegistryDword(HKEY_LOCAL_MACHINE, key, L"Installed", RRF_SUBKEY_WOW6464KEY, installed) || installed != 1) {
+        p.detail = L"not installed";
+        return p;
+    }
+    ReadRegistryDword(HKEY_LOCAL_MACHINE, key, L"Major", RRF_SUBKEY_WOW6464KEY, major);
+    ReadRegistryDword(HKEY_LOCAL_MACHINE, key, L"Minor", RRF_SUBKEY_WOW6464KEY, minor);
+    ReadRegistryDword(HKEY_LOCAL_MACHINE, key, L"Bld", RRF_SUBKEY_WOW6464KEY, build);
+    p.detail = std::to_wstring(major) + L"." + std::to_wstring(minor) + L"." + std::to_wstring(build);
+    if (major != 14 || minor < kMinMinor) {
+        p.detail += L" (older than 14." + std::to_wstring(kMinMinor) + L")";
+        return p;
+    }
+    std::filesystem::path system = std::filesystem::path(SystemToolPath(L"vcruntime140.dll")).parent_path();
+    for (const wchar_t* dll : { L"vcruntime140.dll", L"vcruntime140_1.dll", L"msvcp140.dll" }) {
+        std::error_code ec;
+        if (!std::filesystem::exists(system / dll, ec)) {
+            p.detail += std::wstring(L", missing ") + dll;
+            return p;
+        }
+    }
+    p.healthy = true;
+    return p;
+}
+
+static HealthProbe ProbeWebView2Runtime() {
+    const wchar_t* clientKey = L"Microsoft\\EdgeUpdate\\Clients\\{F3017226-FE2A-4295-8BDF-00C3A9A7E4C5}";
+    HealthProbe p;
+    std::wstring version;
+    bool found = ReadRegistryString(HKEY_LOCAL_MACHINE, (std::wstring(L"SOFTWARE\\") + clientKey).c_str(), L"pv",
+                                    RRF_SUBKEY_WOW6432KEY, version) ||
+                 ReadRegistryString(HKEY_CURRENT_USER, (std::wstring(L"Software\\") + clientKey).c_str(), L"pv", 0, version);
+    if (!found || version.empty() || version == L"0.0.0.0") {
+        p.detail = L"not installed";
+        return p;
+    }
+    p.detail = version;
+    p.healthy = true;
+    return p;
+}
+
+// dism /CheckHealth exits 0 for a repairable store too, so the state comes from
+// DismCheckImageHealth. Only DismImageHealthy counts as healthy.
+static HealthProbe ProbeComponentStore(HWND log) {
+    HealthProbe p;
+    HRESULT hr = DismInitialize(DismLogErrors, nullptr, nullptr);
+    if (FAILED(hr)) {
+        wchar_t code[16];
+        swprintf(code, 16, L"0x%08lX", (unsigned long)hr);
+        p.detail = std::wstring(L"DISM API unavailable (") + code + L")";
+        AppendLog(log, L" DISM health check: " + p.detail);
+        return p;
+    }
+    HANDLE cancel = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    std::atomic<bool> finished{false};
+    std::thread watch([&] {
+        while (!finished.load()) {
+            if (g_cancelRequested.load()) {
+                SetEvent(cancel);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+    });
+    DismSession session = 0;
+    DismImageHealthState state = DismImageNonRepairable;
+    hr = DismOpenSession(DISM_ONLINE_IMAGE, nullptr, nullptr, &session);
+    if (SUCCEEDED(hr)) {
+        hr = DismCheckImageHealth(session, FALSE, cancel, nullptr, nullptr, &state);
+        DismCloseSession(session);
+    }
+    finished = true;
+    watch.join();
+    CloseHandle(cancel);
+    DismShutdown();
+    if (FAILED(hr)) {
+        wchar_t code[16];
+        swprintf(code, 16, L"0x%08lX", (unsigned long)hr);
+        p.detail = std::wstring(L"check did not complete (") + code + L")";
+    } else if (state == DismImageHealthy) {
+        p.healthy = true;
+        p.detail = L"no corruption detected";
+    } else {
+        p.detail = state == DismImageRepairable ? L"corruption found, repairable" : L"corruption found, not repairable";
+    }
+    AppendLog(log, L" DISM health check: " + p.detail);
+    return p;
+}
+
+static bool RuntimeHealthy(HWND log, const wchar_t* id, const wchar_t* label, HealthProbe (*probe)()) {
+    HealthProbe h = DefaultHealthProbes().Get(id, 60 * 60, probe);
+    if (h.healthy) {
+        AppendLog(log, std::wstring(L" ") + label + L" " + h.detail + L" is installed; skipping repair.");
+    } else {
+        AppendLog(log, std::wstring(L" ") + label + L" check failed (" + h.detail + L"); repair needed.");
+    }
+    return h.healthy;
+}
+
+static bool Cleanup(HWND log, const std::function<void(int)>& report, bool& repaired) {
+    repaired = false;
+    AppendLog(log, L"Checking component store health (DISM API)...");
+    HealthProbe health = DefaultHealthProbes().Get(L"component-store", 24 * 60 * 60, [log]() { return ProbeComponentStore(log); });
+    if (health.healthy) {
+        AppendLog(log, L" Component store is healthy (" + health.detail + L"); skipping DISM /RestoreHealth.");
+        return true;
+    }
+    AppendLog(log, L"DISM /Online /Cleanup-Image /RestoreHealth, this may take long depending on your pc...");
+    DWORD code = RunSystemTool(log, L"DISM", L"dism.exe", L"/Online /Cleanup-Image /RestoreHealth", 90 * 60 * 1000, report);
+    AppendLog(log, L" DISM completed with exit code " + std::to_wstring(code));
+    bool ok = code == 0 || code == 1;
+    DefaultHealthProbes().Invalidate(L"component-store");
+    repaired = true;
+    return ok;
+}
+
+static bool Synctime(HWND log) {
+    AppendLog(log, L"Syncing time and date settings (w32tm /resync /rediscover)...");
+    DWORD code = RunSystemTool(log, L"w32tm", L"w32tm.exe", L"/resync /rediscover", 2 * 60 * 1000, nullptr);
+    AppendLog(log, L" w32tm completed with exit code " + std::to_wstring(code));
+    return code == 0 || code == 1;
+}
+
+// After DISM has repaired the component store SFC always runs, since the repair
+// source it restores files from has just changed. Otherwise a clean sfc
+// /verifyonly from the last week is reused, and /scannow runs only if the
+// verify pass reports integrity violations.
+static bool RunSFC(HWND log, const std::function<void(int)>& report, bool componentStoreRepaired) {
+    if (componentStoreRepaired) {
+        DefaultHealthProbes().Invalidate(L"system-files");
+    } else {
+        HealthProbe verify = DefaultHealthProbes().Get(L"system-files", 7 * 24 * 60 * 60, [log, &report]() {
+            AppendLog(log, L"Verifying system files (sfc /verifyonly)...");
+            DWORD code = RunSystemTool(log, L"SFC", L"sfc.exe", L"/verifyonly", 90 * 60 * 1000, report);
+            HealthProbe p;
+            p.healthy = code == 0;
+            p.detail = p.healthy ? L"no integrity violations" : L"sfc /verifyonly exit code " + std::to_wstring(code);
+            return p;
+        });
+        if (verify.healthy) {
+            AppendLog(log, L" System files verified (" + verify.detail + L"); skipping sfc /scannow.");
+            return true;
+        }
+        AppendLog(log, L" " + verify.detail + L"; repair needed.");
+    }
+    AppendLog(log, L"Running system file check, this may take long depending on your pc (sfc /scannow)...");
+    DWORD code = RunSystemTool(log, L"SFC", L"sfc.exe", L"/scannow", 90 * 60 * 1000, report);
+    AppendLog(log, L" SFC completed with exit code " + std::to_wstring(code));
+    return code == 0 || code == 1;
+}
+
+static bool EnableDEP(HWND log) {
+    AppendLog(log, L"Enabling system DEP via Set-ProcessMitigation...");
+    DWORD code = RunPowerShell(L"Set-ProcessMitigation -System -Enable Dep");
+    AppendLog(log, L" DEP command exit code " + std::to_wstring(code));
+    return code == 0;
+}
+
+static bool SetDnsToCloudflare(HWND log) {
+    AppendLog(log, L"Attempting to set DNS to 1.1.1.1 for active adapters...");
+    DWORD code = RunPowerShell(
+        L"Get-NetAdapter -Physical | Where-Object {$_.Status -eq 'Up'} | ForEach-Object { Set-DnsClientServerAddress -InterfaceIndex $_.ifIndex -ServerAddresses '1.1.1.1' -ErrorAction SilentlyContinue }");
+    AppendLog(log, L" DNS change command exit code " + std::to_wstring(code));
+    return code == 0;
+}
+
+static bool DownloadVCRedist(HWND log, std::filesystem::path& dest, const std::function<void(int)>& report) {
+    AppendLog(log, L"Downloading VC++ Redistributable (x64), this may take long depending on your pc...");
+    dest = std::filesystem::path(GetLocalTemp()) / L"vc_redist.x64.exe";
+    if (!DownloadFile(L"https://aka.ms/vs/17/release/vc_redist.x64.exe", dest, log, report)) {
+        AppendLog(log, L" Failed to download VC++ redistributable.");
+        return false;
+    }
+    return true;
+}
+
+static bool InstallOrRepairVCRedist(HWND log, const std::filesystem::path& installer) {
+    AppendLog(log, L" Running VC++ redistributable installer, this may take long depending on your pc (silent)...");
+    DWORD code = RunProcessWait(installer.wstring(), L"/install /quiet /norestart", true);
+    AppendLog(log, L" VC++ installer exit code " + std::to_wstring(code));
+    DefaultHealthProbes().Invalidate(L"vcruntime");
+    return code == 0;
+}
+
+static std::wstring GetDesktopPath() {
+    std::wstring path = GetKnownFolder(FOLDERID_Desktop);
+    if (!path.empty()) return path;
+    std::wstring user = GetEnv(L"USERPROFILE");
+    if (!user.empty()) {
+        std::filesystem::path p = std::filesystem::path(user) / L"Desktop";
+        return p.wstring();
+    }
+    return L"";
+}
+
+static std::wstring GetOneDrivePath() {
+    std::wstring od = GetEnv(L"OneDrive");
+    if (!od.empty()) return od;
+    std::wstring user = GetEnv(L"USERPROFILE");
+    if (!user.empty()) {
+        std::filesystem::path p = std::filesystem::path(user) / L"OneDrive";
+        if (std::filesystem::exists(p)) return p.wstring();
+    }
+    return L"";
+}
+
+struct WalkEntry {
+    std::wstring path;
+    std::wstring name;
+    DWORD attributes{0};
+    unsigned long long size{0};
+    unsigned long long lastWrite{0};
+    int depth{0};
+    bool IsDirectory() const { return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0; }
+};
+
+enum class WalkAction { Continue, SkipChildren };
+
+struct WalkOptions {
+    size_t threads{0};
+    int maxDepth{-1};
+    std::vector<std::wstring> excludeDirs;
+    // Placeholders are still visited, but placeholder folders are not descended
+    // into, since enumerating them makes the sync provider hydrate them.
+    bool skipCloudPlaceholders{true};
+    bool followReparsePoints{false};
+};
+
+struct WalkStats {
+    unsigned long long directories{0};
+    unsigned long long entries{0};
+    unsigned long long cloudPlaceholders{0};
+};
+
+static bool IsCloudPlaceholder(DWORD attributes) {
+    return (attributes & (FILE_ATTRIBUTE_RECALL_ON_DATA_ACCESS | FILE_ATTRIBUTE_RECALL_ON_OPEN | FILE_ATTRIBUTE_OFFLINE)) != 0;
+}
+
+class ParallelTreeWalker {
+public:
+    ParallelTreeWalker(const WalkOptions& opts, const std::function<WalkAction(const WalkEntry&)>& visit)
+        : opts_(opts), visit_(visit) {
+        size_t n = opts_.threads ? opts_.threads : (std::max)(2u, std::thread::hardware_concurrency());
+        queues_.resize((std::min)(n, (size_t)32));
+        for (auto& q : queues_) q.reset(new WorkQueue());
+    }
+
+    WalkStats Run(const std::vector<std::wstring>& roots) {
+        for (size_t i = 0; i < roots.size(); ++i) {
+            if (roots[i].empty()) continue;
+            Push(i % queues_.size(), { roots[i], 0 });
+        }
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < queues_.size(); ++i) threads.emplace_back([this, i]() { Work(i); });
+        Work(0);
+        for (auto& t : threads) t.join();
+        WalkStats s;
+        s.directories = directories_;
+        s.entries = entries_;
+        s.cloudPlaceholders = cloudPlaceholders_;
+        return s;
+    }
+
+private:
+    struct DirTask {
+        std::wstring path;
+        int depth;
+    };
+
+    struct WorkQueue {
+        std::mutex m;
+        std::deque<DirTask> tasks;
+    };
+
+    void Push(size_t q, DirTask task) {
+        ++outstanding_;
+        std::lock_guard<std::mutex> g(queues_[q]->m);
+        queues_[q]->tasks.push_back(std::move(task));
+    }
+
+    bool PopOwn(size_t q, DirTask& task) {
+        std::lock_guard<std::mutex> g(queues_[q]->m);
+        if (queues_[q]->tasks.empty()) return false;
+        task = std::move(queues_[q]->tasks.back());
+        queues_[q]->tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(size_t self, DirTask& task) {
+        for (size_t k = 1; k < queues_.size(); ++k) {
+            size_t victim = (self + k) % queues_.size();
+            std::lock_guard<std::mutex> g(queues_[victim]->m);
+            if (queues_[victim]->tasks.empty()) continue;
+            task = std::move(queues_[victim]->tasks.front());
+            queues_[victim]->tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void Work(size_t self) {
+        int idle = 0;
+        while (outstanding_.load() > 0) {
+            DirTask task;
+            if (PopOwn(self, task) || Steal(self, task)) {
+                idle = 0;
+                Enumerate(self, task);
+                --outstanding_;
+                continue;
+            }
+            if (++idle < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool IsExcluded(const std::wstring& name) const {
+        for (const auto& x : opts_.excludeDirs) {
+            if (CaseInsensitiveEquals(name, x)) return true;
+        }
+        return false;
+    }
+
+    void Enumerate(size_t self, const DirTask& task) {
+        ++directories_;
+        WIN32_FIND_DATAW fd;
+        std::wstring pattern = task.path;
+        if (!pattern.empty() && pattern.back() != L'\\') pattern += L'\\';
+        std::wstring prefix = pattern;
+        pattern += L'*';
+        HANDLE h = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr,
+                                    FIND_FIRST_EX_LARGE_FETCH);
+        if (h == INVALID_HANDLE_VALUE) return;
+        WalkEntry e;
+        e.depth = task.depth + 1;
+        do {
+            const wchar_t* n = fd.cFileName;
+            if (n[0] == L'.' && (n[1] == 0 || (n[1] == L'.' && n[2] == 0))) continue;
+            ++entries_;
+            e.name = n;
+            e.path = prefix + e.name;
+            e.attributes = fd.dwFileAttributes;
+            e.size = ((unsigned long long)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+            e.lastWrite = ((unsigned long long)fd.ftLastWriteTime.dwHighDateTime << 32) | fd.ftLastWriteTime.dwLowDateTime;
+            WalkAction action = visit_ ? visit_(e) : WalkAction::Continue;
+            bool placeholder = IsCloudPlaceholder(e.attributes);
+            if (placeholder) ++cloudPlaceholders_;
+            if (!e.IsDirectory() || action == WalkAction::SkipChildren) continue;
+            if (placeholder && opts_.skipCloudPlaceholders) continue;
+            if (!opts_.followReparsePoints && (e.attributes & FILE_ATTRIBUTE_REPARSE_POINT)) continue;
+            if (opts_.maxDepth >= 0 && e.depth >= opts_.maxDepth) continue;
+            if (IsExcluded(e.name)) continue;
+            Push(self, { e.path, e.depth });
+        } while (FindNextFileW(h, &fd));
+        FindClose(h);
+    }
+
+    WalkOptions opts_;
+    std::function<WalkAction(const WalkEntry&)> visit_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::atomic<long long> outstanding_{0};
+    std::atomic<unsigned long long> directories_{0};
+    std::atomic<unsigned long long> entries_{0};
+    std::atomic<unsigned long long> cloudPlaceholders_{0};
+};
+
+static WalkStats WalkTrees(const std::vector<std::wstring>& roots, const WalkOptions& opts,
+                           const std::function<WalkAction(const WalkEntry&)>& visit) {
+    TraceScope trace(L"fs", L"walk");
+    ParallelTreeWalker walker(opts, visit);
+    WalkStats stats = walker.Run(roots);
+    trace.Files(stats.entries);
+    return stats;
+}
+
+struct BulkCopyReport {
+    size_t files{0};
+    size_t cloned{0};
+    size_t linked{0};
+    size_t failed{0};
+    unsigned long long bytes{0};
+    std::vector<std::wstring> errors;
+};
+
+struct IFileSystem {
+    virtual ~IFileSystem() = default;
+    virtual WalkStats Walk(const std::vector<std::wstring>& roots, const WalkOptions& opts,
+                           const std::function<WalkAction(const WalkEntry&)>& visit) = 0;
+    virtual bool Exists(const std::filesystem::path& p) = 0;
+    virtual bool IsDirectory(const std::filesystem::path& p) = 0;
+    virtual bool FileSize(const std::filesystem::path& p, unsigned long long& size) = 0;
+    virtual std::vector<std::wstring> List(const std::filesystem::path& dir) = 0;
+    virtual bool CreateDirectories(const std::filesystem::path& p) = 0;
+    virtual bool ReadText(const std::filesystem::path& p, std::string& data) = 0;
+    virtual bool ReadStream(const std::filesystem::path& p, const std::function<void(const char*, size_t)>& sink) = 0;
+    virtual bool WriteTextAtomic(const std::filesystem::path& p, const std::string& data) = 0;
+    virtual bool AppendText(const std::filesystem::path& p, const std::string& data) = 0;
+    virtual bool ReadRange(const std::filesystem::path& p, unsigned long long offset, size_t size, std::string& data) = 0;
+    virtual bool SetLastWrite(const std::filesystem::path& p, unsigned long long mtime) = 0;
+    virtual bool CopyFileHashed(const std::filesystem::path& src, const std::filesystem::path& dst, std::wstring& hash,
+                                unsigned long long& size, unsigned long long mtime) = 0;
+    virtual BulkCopyReport CopyTree(const std::filesystem::path& src, const std::filesystem::path& dst) = 0;
+    virtual bool Rename(const std::filesystem::path& src, const std::filesystem::path& dst) = 0;
+    virtual bool Replace(const std::filesystem::path& src, const std::filesystem::path& dst) = 0;
+    virtual bool HardLink(const std::filesystem::path& existing, const std::filesystem::path& link) = 0;
+    virtual unsigned LinkCount(const std::filesystem::path& p) = 0;
+    virtual bool RemoveFile(const std::filesystem::path& p, DWORD attributes) = 0;
+    virtual bool RemoveEmptyDirectory(const std::filesystem::path& p) = 0;
+    virtual void RemoveAll(const std::filesystem::path& p) = 0;
+};
+
+static void AddZenithDefenderExclusions(HWND log) {
+    AppendLog(log, L"Scanning Downloads, Desktop, and OneDrive for targets to add Defender exclusions...");
+
+    std::vector<std::wstring> roots;
+    std::wstring downloads = GetDownloadsPath();
+    if (!downloads.empty()) roots.push_back(downloads);
+    std::wstring desktop = GetDesktopPath();
+    if (!desktop.empty()) roots.push_back(desktop);
+    std::wstring onedrive = GetOneDrivePath();
+    if (!onedrive.empty()) roots.push_back(onedrive);
+
+    if (roots.empty()) {
+        AppendLog(log, L" Unable to resolve any of Downloads, Desktop, or OneDrive.");
+        return;
+    }
+
+    static const NameMatcher targets({ L"Zenith.exe", L"luau-lsp", L"Zenith-Module.dll" });
+    std::mutex found;
+    std::vector<std::wstring> matches;
+
+    WalkOptions opts;
+    opts.excludeDirs = { L"$RECYCLE.BIN", L"System Volume Information" };
+    auto started = std::chrono::steady_clock::now();
+    WalkStats stats = WalkTrees(roots, opts, [&](const WalkEntry& entry) {
+        if (!targets.Any(entry.name)) return WalkAction::Continue;
+        {
+            std::lock_guard<std::mutex> g(found);
+            matches.push_back(entry.path);
+        }
+        return entry.IsDirectory() ? WalkAction::SkipChildren : WalkAction::Continue;
+    });
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    AppendLog(log, L" Scanned " + std::to_wstring(stats.entries) + L" entries in " + std::to_wstring(stats.directories) +
+                   L" folders (" + std::to_wstring(elapsed.count()) + L" ms, " + std::to_wstring(stats.cloudPlaceholders) +
+                   L" cloud-only placeholders left unopened).");
+
+    std::sort(matches.begin(), matches.end());
+    std::set<std::wstring> addedExclusions;
+    std::vector<std::wstring> exclusionOrder;
+    for (const auto& foundPath : matches) {
+        std::wstring exclusionPath = foundPath;
+        if (addedExclusions.insert(exclusionPath).second) {
+            AppendLog(log, L" Adding Defender exclusion: " + exclusionPath);
+            exclusionOrder.push_back(exclusionPath);
+        }
+
+        std::filesystem::path parent = std::filesystem::path(foundPath).parent_path();
+        if (!parent.empty()) {
+            std::wstring parentPath = parent.wstring();
+            if (addedExclusions.insert(parentPath).second) {
+                AppendLog(log, L" Adding Defender exclusion for parent folder: " + parentPath);
+                exclusionOrder.push_back(parentPath);
+            }
+        }
+    }
+
+    std::vector<std::wstring> scripts;
+    for (const auto& path : exclusionOrder) scripts.push_back(L"Add-MpPreference -ExclusionPath " + PsQuote(path));
+    std::vector<ShellResult> results = DefaultPowerShellHost().RunBatch(scripts);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].exitCode != 0) {
+            AppendLog(log, L" Add-MpPreference failed (" + std::to_wstring(results[i].exitCode) + L"): " + exclusionOrder[i]);
+        }
+    }
+
+    if (addedExclusions.empty()) {
+        AppendLog(log, L"No matching files or folders found to add exclusions for.");
+    } else {
+        AppendLog(log, L"Finished adding Defender exclusions.");
+    }
+}
+
+static void ParallelFor(size_t count, size_t threads, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (threads == 0) threads = (std::max)(2u, std::thread::hardware_concurrency());
+    threads = (std::min)(threads, count);
+    std::atomic<size_t> next{0};
+    auto body = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(body);
+    body();
+    for (auto& t : pool) t.join();
+}
+
+static bool CopyFileHashed(const std::filesystem::path& src, const std::filesystem::path& dst,
+                           std::wstring& hash, unsigned long long& size, unsigned long long mtime = 0) {
+    HANDLE in = CreateFileW(src.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (in == INVALID_HANDLE_VALUE) return false;
+    std::filesystem::path tmp = dst;
+    tmp += L".zftmp";
+    HANDLE out = CreateFileW(tmp.wstring().c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (out == INVALID_HANDLE_VALUE) {
+        CloseHandle(in);
+        return false;
+    }
+    Sha256 sha;
+    std::vector<char> buf(1024 * 1024);
+    bool ok = true;
+    size = 0;
+    for (;;) {
+        DWORD read = 0, wrote = 0;
+        if (!ReadFile(in, buf.data(), (DWORD)buf.size(), &read, nullptr)) { ok = false; break; }
+        if (read == 0) break;
+        sha.Update(buf.data(), read);
+        if (!WriteFile(out, buf.data(), read, &wrote, nullptr) || wrote != read) { ok = false; break; }
+        size += read;
+    }
+    if (ok && mtime) {
+        FILETIME ft;
+        ft.dwLowDateTime = (DWORD)(mtime & 0xFFFFFFFFull);
+        ft.dwHighDateTime = (DWORD)(mtime >> 32);
+        SetFileTime(out, nullptr, nullptr, &ft);
+    }
+    CloseHandle(in);
+    CloseHandle(out);
+    hash = ok ? sha.FinishHex() : L"";
+    std::error_code ec;
+    if (!ok || hash.empty() || !MoveFileExW(tmp.wstring().c_str(), dst.wstring().c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+static bool CompressBlock(const std::string& raw, std::string& stored, int& method) {
+    COMPRESSOR_HANDLE c = nullptr;
+    method = 0;
+    stored = raw;
+    if (raw.size() < 512 || !CreateCompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &c)) return true;
+    std::string out(raw.size(), '\0');
+    size_t written = 0;
+    if (Compress(c, raw.data(), raw.size(), &out[0], out.size(), &written) && written < raw.size()) {
+        out.resize(written);
+        stored = std::move(out);
+        method = 1;
+    }
+    CloseCompressor(c);
+    return true;
+}
+
+static bool DecompressBlock(const std::string& stored, int method, size_t rawSize, std::string& raw) {
+    if (method == 0) {
+        raw = stored;
+        return raw.size() == rawSize;
+    }
+    DECOMPRESSOR_HANDLE d = nullptr;
+    if (method != 1 || !CreateDecompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &d)) return false;
+    raw.assign(rawSize, '\0');
+    size_t written = 0;
+    bool ok = Decompress(d, stored.data(), stored.size(), rawSize ? &raw[0] : nullptr, rawSize, &written) && written == rawSize;
+    CloseDecompressor(d);
+    return ok;
+}
+
+struct ArchiveReport {
+    size_t files{0};
+    size_t reused{0};
+    size_t carried{0};
+    size_t extracted{0};
+    size_t failed{0};
+    unsigned long long rawBytes{0};
+    unsigned long long readBytes{0};
+    unsigned long long archiveBytes{0};
+    std::vector<std::wstring> errors;
+};
+
+struct SnapshotEntry {
+    std::wstring rel;
+    bool directory{false};
+    unsigned long long size{0};
+    unsigned long long mtime{0};
+    std::wstring hash;
+};
+
+// Read-only view of the Snapshots/Blobs store older builds kept next to the
+// archive. BackupArchive::Import folds it in; nothing writes to it any more.
+class LegacySnapshotStore {
+public:
+    LegacySnapshotStore(IFileSystem& fs, std::filesystem::path root) : fs_(fs), root_(std::move(root)) {}
+
+    bool Present() const {
+        return fs_.Exists(root_ / L"Snapshots") || fs_.Exists(root_ / L"Blobs");
+    }
+
+    bool HasSnapshot(const std::wstring& set) const {
+        return fs_.Exists(ManifestPath(set));
+    }
+
+    std::filesystem::path BlobPath(const std::wstring& hash) const {
+        return root_ / L"Blobs" / hash.substr(0, 2) / hash;
+    }
+
+    bool Load(const std::wstring& set, std::vector<SnapshotEntry>& entries) const {
+        std::string text;
+        if (!fs_.ReadText(ManifestPath(set), text)) return false;
+        std::istringstream in(text);
+        std::string line;
+        if (!std::getline(in, line) || line != "zfsnap1") return false;
+        while (std::getline(in, line)) {
+            std::vector<std::string> f;
+            size_t pos = 0;
+            for (;;) {
+                size_t tab = line.find('\t', pos);
+                f.push_back(line.substr(pos, tab == std::string::npos ? std::string::npos : tab - pos));
+                if (tab == std::string::npos) break;
+                pos = tab + 1;
+            }
+            SnapshotEntry e;
+            if (f.size() == 2 && f[0] == "D") {
+                e.directory = true;
+                e.rel = FromUtf8(f[1]);
+            } else if (f.size() == 5 && f[0] == "F" && f[4].size() > 2) {
+                e.rel = FromUtf8(f[1]);
+                e.size = std::strtoull(f[2].c_str(), nullptr, 10);
+                e.mtime = std::strtoull(f[3].c_str(), nullptr, 10);
+                e.hash = FromUtf8(f[4]);
+            } else {
+                continue;
+            }
+            entries.push_back(std::move(e));
+        }
+        return true;
+    }
+
+    void Remove() const {
+        fs_.RemoveAll(root_ / L"Snapshots");
+        fs_.RemoveAll(root_ / L"Blobs");
+    }
+
+private:
+    std::filesystem::path ManifestPath(const std::wstring& set) const {
+        return root_ / L"Snapshots" / (set + L".manifest");
+    }
+
+    IFileSystem& fs_;
+    std::filesystem::path root_;
+};
+
+class BackupArchive {
+public:
+    static constexpr size_t kBlockSize = 1024 * 1024;
+
+    BackupArchive(IFileSystem& fs, std::filesystem::path root) : fs_(fs), root_(std::move(root)) {
+        fs_.CreateDirectories(root_ / L"Archives");
+    }
+
+    bool HasArchive(const std::wstring& set) const {
+        return fs_.Exists(ArchivePath(set));
+    }
+
+    // Merges src into the set's archive. Files missing from src are carried
+    // forward, and runs of blocks whose files are all unchanged are copied
+    // across as stored instead of being read and compressed again.
+    ArchiveReport Backup(const std::wstring& set, const std::filesystem::path& src) {
+        TraceScope trace(L"archive", L"backup");
+        trace.Detail(set);
+        std::mutex m;
+        std::vector<Entry> entries;
+        std::wstring base = src.wstring();
+        WalkOptions opts;
+        opts.skipCloudPlaceholders = false;
+        fs_.Walk({ base }, opts, [&](const WalkEntry& w) {
+            Entry e;
+            e.rel = w.path.substr(base.size() + 1);
+            e.directory = w.IsDirectory();
+            e.size = w.size;
+            e.mtime = w.lastWrite;
+            std::lock_guard<std::mutex> g(m);
+            entries.push_back(std::move(e));
+            return WalkAction::Continue;
+        });
+        ArchiveReport report = Merge(set, std::move(entries), [&](const Entry& e, const Sink& sink) {
+            return fs_.ReadStream(src / e.rel, sink);
+        });
+        trace.Files(report.files - report.failed);
+        trace.Bytes(report.readBytes);
+        trace.Result((long long)report.failed);
+        return report;
+    }
+
+    // Adds the files of a legacy snapshot the archive does not already hold.
+    ArchiveReport Import(const std::wstring& set, const LegacySnapshotStore& store) {
+        TraceScope trace(L"archive", L"import");
+        trace.Detail(set);
+        ArchiveReport report;
+        std::vector<SnapshotEntry> snapshot;
+        if (!store.Load(set, snapshot)) {
+            report.failed = 1;
+            report.errors.push_back(L"Unreadable snapshot manifest for " + set);
+            return report;
+        }
+        Index current;
+        std::set<std::wstring> held;
+        if (LoadIndex(set, current)) {
+            for (const auto& e : current.entries) held.insert(Key(e.rel));
+        }
+        std::vector<Entry> entries;
+        std::map<std::wstring, std::wstring> blobs;
+        for (const auto& s : snapshot) {
+            if (held.count(Key(s.rel))) continue;
+            Entry e;
+            e.rel = s.rel;
+            e.directory = s.directory;
+            e.size = s.size;
+            e.mtime = s.mtime;
+            if (!s.directory) blobs[s.rel] = s.hash;
+            entries.push_back(std::move(e));
+        }
+        if (entries.empty()) return report;
+        report = Merge(set, std::move(entries), [&](const Entry& e, const Sink& sink) {
+            const std::wstring& hash = blobs[e.rel];
+            Sha256 sha;
+            bool read = fs_.ReadStream(store.BlobPath(hash), [&](const char* data, size_t n) {
+                sha.Update(data, n);
+                sink(data, n);
+            });
+            return read && sha.FinishHex() == hash;
+        });
+        trace.Files(report.files - report.failed);
+        trace.Bytes(report.readBytes);
+        trace.Result((long long)report.failed);
+        return report;
+    }
+
+    ArchiveReport Restore(const std::wstring& set, const std::filesystem::path& dst) {
+        TraceScope trace(L"archive", L"restore");
+        trace.Detail(set);
+        ArchiveReport report;
+        Index idx;
+        if (!LoadIndex(set, idx)) {
+            report.errors.push_back(L"Unreadable archive " + ArchivePath(set).wstring());
+            report.failed = 1;
+            return report;
+        }
+        fs_.CreateDirectories(dst);
+        std::map<size_t, std::vector<size_t>> byBlock;
+        for (size_t i = 0; i < idx.entries.size(); ++i) {
+            const Entry& e = idx.entries[i];
+            if (e.directory) fs_.CreateDirectories(dst / e.rel);
+            else byBlock[e.block].push_back(i);
+        }
+        std::vector<const std::vector<size_t>*> groups;
+        for (const auto& kv : byBlock) groups.push_back(&kv.second);
+
+        std::mutex m;
+        ParallelFor(groups.size(), 0, [&](size_t g) {
+            std::string block;
+            size_t loaded = (size_t)-1;
+            for (size_t i : *groups[g]) {
+                const Entry& e = idx.entries[i];
+                std::string data;
+                bool ok;
+                if (e.block < idx.blocks.size() && e.offset + e.size <= idx.blocks[e.block].raw) {
+                    ok = loaded == e.block || ReadBlock(set, idx, e.block, block);
+                    loaded = ok ? e.block : (size_t)-1;
+                    if (ok) data = block.substr(e.offset, e.size);
+                } else {
+                    ok = ReadSpan(set, idx, e, data);
+                }
+                std::filesystem::path target = dst / e.rel;
+                ok = ok && fs_.CreateDirectories(target.parent_path()) && fs_.WriteTextAtomic(target, data);
+                if (ok && e.mtime) fs_.SetLastWrite(target, e.mtime);
+                std::lock_guard<std::mutex> lock(m);
+                ++report.files;
+                if (ok) {
+                    ++report.extracted;
+                    report.rawBytes += e.size;
+                } else {
+                    ++report.failed;
+                    report.errors.push_back(e.rel);
+                }
+            }
+        });
+        fs_.FileSize(ArchivePath(set), report.archiveBytes);
+        trace.Files(report.extracted);
+        trace.Bytes(report.rawBytes);
+        trace.Result((long long)report.failed);
+        return report;
+    }
+
+    bool Extract(const std::wstring& set, const std::wstring& rel, std::string& data) {
+        TraceScope trace(L"archive", L"extract");
+        trace.Detail(rel);
+        Index idx;
+        if (!LoadIndex(set, idx)) return false;
+        for (const auto& e : idx.entries) {
+            if (e.directory || !CaseInsensitiveEquals(e.rel, rel)) continue;
+            trace.Bytes(e.size);
+            return ReadSpan(set, idx, e, data);
+        }
+        return false;
+    }
+
+private:
+    static constexpr size_t kNone = (size_t)-1;
+
+    struct Entry {
+        std::wstring rel;
+        bool directory{false};
+        unsigned long long size{0};
+        unsigned long long mtime{0};
+        size_t block{0};
+        size_t offset{0};
+        size_t previous{kNone};
+        bool carried{false};
+    };
+
+    struct Block {
+        unsigned long long offset{0};
+        size_t stored{0};
+        size_t raw{0};
+        int method{0};
+        std::wstring hash;
+    };
+
+    struct Index {
+        std::vector<Block> blocks;
+        std::vector<Entry> entries;
+    };
+
+    using Sink = std::function<void(const char*, size_t)>;
+    using Reader = std::function<bool(const Entry&, const Sink&)>;
+
+    inline static const std::string kMagic = "ZFARC001";
+    inline static const std::string kTrailer = "ZFIDX001";
+
+    std::filesystem::path ArchivePath(const std::wstring& set) const {
+        return root_ / L"Archives" / (set + L".zfa");
+    }
+
+    static std::wstring Key(const std::wstring& rel) {
+        std::wstring key = rel;
+        for (auto& c : key) c = (wchar_t)towlower(c);
+        return key;
+    }
+
+    static void PutU64(std::string& out, unsigned long long v) {
+        for (int i = 0; i < 8; ++i) out.push_back((char)((v >> (8 * i)) & 0xFF));
+    }
+
+    static unsigned long long GetU64(const std::string& in, size_t pos) {
+        unsigned long long v = 0;
+        for (int i = 7; i >= 0; --i) v = (v << 8) | (unsigned char)in[pos + i];
+        return v;
+    }
+
+    // Index of the last block holding e's data, or kNone if the index does not cover it.
+    static size_t LastBlock(const Index& idx, const Entry& e) {
+        if (!e.size || e.block >= idx.blocks.size() || e.offset >= idx.blocks[e.block].raw) return kNone;
+        size_t last = e.block;
+        unsigned long long covered = idx.blocks[last].raw - e.offset;
+        while (covered < e.size) {
+            if (++last >= idx.blocks.size()) return kNone;
+            covered += idx.blocks[last].raw;
+        }
+        return last;
+    }
+
+    // Writes the merged archive to a temporary file and swaps it in. Blocks of
+    // the previous archive form units joined by files that straddle them; a unit
+    // none of whose files changed is copied as stored, everything else is packed
+    // again from src or, for carried-forward files, from the previous archive.
+    ArchiveReport Merge(const std::wstring& set, std::vector<Entry> entries, const Reader& read) {
+        ArchiveReport report;
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.rel < b.rel; });
+        Index prev;
+        LoadIndex(set, prev);
+
+        std::map<std::wstring, std::wstring> dirs;
+        std::unordered_map<std::wstring, size_t> sourceFiles;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].directory) dirs[Key(entries[i].rel)] = entries[i].rel;
+            else sourceFiles[Key(entries[i].rel)] = i;
+        }
+
+        std::vector<size_t> last(prev.entries.size(), kNone);
+        std::vector<bool> joined(prev.blocks.size(), false);
+        for (size_t j = 0; j < prev.entries.size(); ++j) {
+            const Entry& pe = prev.entries[j];
+            if (pe.directory) continue;
+            last[j] = LastBlock(prev, pe);
+            for (size_t b = pe.block; last[j] != kNone && b < last[j]; ++b) joined[b] = true;
+        }
+        std::vector<size_t> unitOf(prev.blocks.size());
+        size_t units = 0;
+        for (size_t b = 0; b < prev.blocks.size(); ++b) {
+            unitOf[b] = units;
+            if (!joined[b]) ++units;
+        }
+        std::vector<bool> used(units, false), dirty(units, false);
+        std::vector<Entry> carried;
+        for (size_t j = 0; j < prev.entries.size(); ++j) {
+            const Entry& pe = prev.entries[j];
+            if (pe.directory) {
+                dirs.emplace(Key(pe.rel), pe.rel);
+                continue;
+            }
+            if (last[j] != kNone) used[unitOf[pe.block]] = true;
+            auto it = sourceFiles.find(Key(pe.rel));
+            if (it == sourceFiles.end()) {
+                Entry e = pe;
+                e.previous = j;
+                e.carried = true;
+                carried.push_back(std::move(e));
+                continue;
+            }
+            Entry& s = entries[it->second];
+            s.previous = j;
+            if (last[j] != kNone && (s.size != pe.size || s.mtime != pe.mtime)) dirty[unitOf[pe.block]] = true;
+        }
+
+        std::filesystem::path tmp = ArchivePath(set);
+        tmp += L".tmp";
+        fs_.RemoveFile(tmp, 0);
+        std::vector<Block> blocks;
+        std::vector<size_t> remap(prev.blocks.size(), kNone);
+        bool ok = fs_.AppendText(tmp, kMagic);
+        unsigned long long offset = kMagic.size();
+
+        std::string copied;
+        auto spill = [&]() {
+            if (!copied.empty()) ok = ok && fs_.AppendText(tmp, copied);
+            offset += copied.size();
+            copied.clear();
+        };
+        for (size_t b = 0; b < prev.blocks.size() && ok; ++b) {
+            size_t u = unitOf[b];
+            if (!used[u] || dirty[u]) continue;
+            std::string stored;
+            if (!fs_.ReadRange(ArchivePath(set), prev.blocks[b].offset, prev.blocks[b].stored, stored)) {
+                dirty[u] = true;
+                continue;
+            }
+            remap[b] = blocks.size();
+            Block nb = prev.blocks[b];
+            nb.offset = offset + copied.size();
+            blocks.push_back(std::move(nb));
+            copied += stored;
+            if (copied.size() >= 8 * kBlockSize) spill();
+        }
+        spill();
+
+        // A unit that failed to copy part way leaves unreferenced blocks behind;
+        // its files are packed again below.
+        auto reusable = [&](const Entry& e) {
+            if (e.previous == kNone || last[e.previous] == kNone) return false;
+            const Entry& pe = prev.entries[e.previous];
+            if (e.size != pe.size || e.mtime != pe.mtime || dirty[unitOf[pe.block]]) return false;
+            for (size_t b = pe.block; b <= last[e.previous]; ++b) {
+                if (remap[b] == kNone) return false;
+            }
+            return true;
+        };
+
+        std::vector<Entry> files, work;
+        for (auto& e : entries) {
+            if (e.directory) continue;
+            ++report.files;
+            (reusable(e) ? files : work).push_back(std::move(e));
+        }
+        for (auto& e : carried) {
+            ++report.files;
+            ++report.carried;
+            (reusable(e) ? files : work).push_back(std::move(e));
+        }
+        for (auto& e : files) {
+            const Entry& pe = prev.entries[e.previous];
+            e.block = remap[pe.block];
+            e.offset = pe.offset;
+            report.rawBytes += e.size;
+            if (!e.carried) ++report.reused;
+        }
+        std::sort(work.begin(), work.end(), [](const Entry& a, const Entry& b) { return a.rel < b.rel; });
+
+        std::vector<std::string> pending;
+        std::string current;
+        size_t window = (std::max)(4u, std::thread::hardware_concurrency() * 2);
+        auto flush = [&]() {
+            std::vector<Block> done(pending.size());
+            std::vector<std::string> stored(pending.size());
+            ParallelFor(pending.size(), 0, [&](size_t i) {
+                Sha256 sha;
+                sha.Update(pending[i].data(), pending[i].size());
+                done[i].hash = sha.FinishHex();
+                done[i].raw = pending[i].size();
+                CompressBlock(pending[i], stored[i], done[i].method);
+            });
+            std::string out;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                done[i].offset = offset + out.size();
+                done[i].stored = stored[i].size();
+                out += stored[i];
+                blocks.push_back(done[i]);
+            }
+            if (!out.empty()) ok = ok && fs_.AppendText(tmp, out);
+            offset += out.size();
+            pending.clear();
+        };
+        auto seal = [&]() {
+            if (!current.empty()) pending.push_back(std::move(current));
+            current.clear();
+            if (pending.size() >= window) flush();
+        };
+        unsigned long long streamed = 0;
+        Sink append = [&](const char* data, size_t n) {
+            streamed += n;
+            while (n) {
+                if (current.empty()) current.reserve(kBlockSize);
+                size_t take = (std::min)(n, kBlockSize - current.size());
+                current.append(data, take);
+                data += take;
+                n -= take;
+                if (current.size() == kBlockSize) seal();
+            }
+        };
+        auto place = [&](const Entry& e) {
+            if (e.size > kBlockSize || current.size() + e.size > kBlockSize) seal();
+            streamed = 0;
+            return std::make_pair(blocks.size() + pending.size(), current.size());
+        };
+
+        for (auto& e : work) {
+            if (!ok) break;
+            std::tie(e.block, e.offset) = place(e);
+            bool done = e.carried ? StreamSpan(set, prev, prev.entries[e.previous], append) : read(e, append);
+            if (!done && !e.carried) {
+                ++report.failed;
+                if (e.previous != kNone) {
+                    // Keep the copy from the last backup rather than losing the file.
+                    const Entry& pe = prev.entries[e.previous];
+                    std::tie(e.block, e.offset) = place(pe);
+                    if (StreamSpan(set, prev, pe, append)) {
+                        e.size = pe.size;
+                        e.mtime = pe.mtime;
+                        report.errors.push_back(e.rel + L" (kept the previous copy)");
+                        report.rawBytes += streamed;
+                        files.push_back(std::move(e));
+                        continue;
+                    }
+                }
+                report.errors.push_back(e.rel);
+                continue;
+            }
+            if (!done) {
+                ++report.failed;
+                report.errors.push_back(e.rel + L" (previous copy unreadable)");
+                continue;
+            }
+            e.size = streamed;
+            report.rawBytes += streamed;
+            if (!e.carried) report.readBytes += streamed;
+            files.push_back(std::move(e));
+        }
+        if (!current.empty()) pending.push_back(std::move(current));
+        flush();
+
+        std::sort(files.begin(), files.end(), [](const Entry& a, const Entry& b) { return a.rel < b.rel; });
+        std::ostringstream index;
+        index << "zfarc1\n";
+        for (const auto& b : blocks) {
+            index << "B\t" << b.offset << "\t" << b.stored << "\t" << b.raw << "\t" << b.method << "\t" << ToUtf8(b.hash) << "\n";
+        }
+        for (const auto& d : dirs) index << "D\t" << ToUtf8(d.second) << "\n";
+        for (const auto& e : files) {
+            index << "F\t" << ToUtf8(e.rel) << "\t" << e.size << "\t" << e.mtime << "\t" << e.block << "\t" << e.offset << "\n";
+        }
+        std::string indexRaw = index.str(), indexStored;
+        int indexMethod = 0;
+        CompressBlock(indexRaw, indexStored, indexMethod);
+        std::string trailer = kTrailer;
+        PutU64(trailer, offset);
+        PutU64(trailer, indexStored.size());
+        PutU64(trailer, indexRaw.size());
+        PutU64(trailer, (unsigned long long)indexMethod);
+        ok = ok && fs_.AppendText(tmp, indexStored + trailer);
+        report.archiveBytes = offset + indexStored.size() + trailer.size();
+
+        ok = ok && fs_.Replace(tmp, ArchivePath(set));
+        if (!ok) {
+            fs_.RemoveFile(tmp, 0);
+            report.failed = report.files;
+            report.errors.push_back(L"Could not write " + ArchivePath(set).wstring());
+        }
+        return report;
+    }
+
+    bool LoadIndex(const std::wstring& set, Index& idx) const {
+        std::filesystem::path path = ArchivePath(set);
+        unsigned long long size = 0;
+        std::string trailer, stored, text;
+        size_t trailerSize = kTrailer.size() + 32;
+        if (!fs_.FileSize(path, size) || size < kMagic.size() + trailerSize) return false;
+        if (!fs_.ReadRange(path, size - trailerSize, trailerSize, trailer) || trailer.compare(0, kTrailer.size(), kTrailer) != 0) return false;
+        unsigned long long at = GetU64(trailer, 8), storedSize = GetU64(trailer, 16), rawSize = GetU64(trailer, 24);
+        if (at + storedSize + trailerSize != size || rawSize > 1024ull * 1024 * 1024) return false;
+        if (!fs_.ReadRange(path, at, (size_t)storedSize, stored) ||
+            !DecompressBlock(stored, (int)GetU64(trailer, 32), (size_t)rawSize, text)) {
+            return false;
+        }
+        std::istringstream in(text);
+        std::string line;
+        if (!std::getline(in, line) || line != "zfarc1") return false;
+        while (std::getline(in, line)) {
+            std::vector<std::string> f;
+            size_t pos = 0;
+            for (;;) {
+                size_t tab = line.find('\t', pos);
+                f.push_back(line.substr(pos, tab == std::string::npos ? std::string::npos : tab - pos));
+                if (tab == std::string::npos) break;
+                pos = tab + 1;
+            }
+            if (f.size() == 6 && f[0] == "B") {
+                Block b;
+                b.offset = std::strtoull(f[1].c_str(), nullptr, 10);
+                b.stored = (size_t)std::strtoull(f[2].c_str(), nullptr, 10);
+                b.raw = (size_t)std::strtoull(f[3].c_str(), nullptr, 10);
+                b.method = std::atoi(f[4].c_str());
+                b.hash = FromUtf8(f[5]);
+                idx.blocks.push_back(std::move(b));
+            } else if (f.size() == 2 && f[0] == "D") {
+                Entry e;
+                e.directory = true;
+                e.rel = FromUtf8(f[1]);
+                idx.entries.push_back(std::move(e));
+            } else if (f.size() == 6 && f[0] == "F") {
+                Entry e;
+                e.rel = FromUtf8(f[1]);
+                e.size = std::strtoull(f[2].c_str(), nullptr, 10);
+                e.mtime = std::strtoull(f[3].c_str(), nullptr, 10);
+                e.block = (size_t)std::strtoull(f[4].c_str(), nullptr, 10);
+                e.offset = (size_t)std::strtoull(f[5].c_str(), nullptr, 10);
+                idx.entries.push_back(std::move(e));
+            }
+        }
+        return true;
+    }
+
+    bool ReadBlock(const std::wstring& set, const Index& idx, size_t i, std::string& raw) const {
+        if (i >= idx.blocks.size()) return false;
+        const Block& b = idx.blocks[i];
+        std::string stored;
+        if (!fs_.ReadRange(ArchivePath(set), b.offset, b.stored, stored) || !DecompressBlock(stored, b.method, b.raw, raw)) {
+            return false;
+        }
+        Sha256 sha;
+        sha.Update(raw.data(), raw.size());
+        return sha.FinishHex() == b.hash;
+    }
+
+    bool StreamSpan(const std::wstring& set, const Index& idx, const Entry& e, const Sink& sink) const {
+        unsigned long long left = e.size;
+        size_t skip = e.offset;
+        for (size_t i = e.block; left; ++i) {
+            std::string raw;
+            if (!ReadBlock(set, idx, i, raw) || raw.size() <= skip) return false;
+            size_t take = (size_t)(std::min)(left, (unsigned long long)(raw.size() - skip));
+            sink(raw.data() + skip, take);
+            left -= take;
+            skip = 0;
+        }
+        return true;
+    }
+
+    bool ReadSpan(const std::wstring& set, const Index& idx, const Entry& e, std::string& data) const {
+        data.clear();
+        data.reserve((size_t)e.size);
+        return StreamSpan(set, idx, e, [&](const char* p, size_t n) { data.append(p, n); });
+    }
+
+    IFileSystem& fs_;
+    std::filesystem::path root_;
+};
+
+static void LogArchiveReport(HWND log, const std::wstring& what, const ArchiveReport& r) {
+    AppendLog(log, L" " + what + L": " + std::to_wstring(r.files) + L" files, " +
+                   FormatBytes(r.rawBytes) + L" in a " + FormatBytes(r.archiveBytes) + L" archive, " +
+                   std::to_wstring(r.failed) + L" failed.");
+    if (r.reused || r.carried) {
+        AppendLog(log, L"  " + std::to_wstring(r.reused) + L" unchanged files reused, " + std::to_wstring(r.carried) +
+                       L" kept from earlier backups, " + FormatBytes(r.readBytes) + L" read.");
+    }
+    for (size_t i = 0; i < r.errors.size() && i < 10; ++i) AppendLog(log, L"  Failed: " + r.errors[i]);
+    if (r.errors.size() > 10) AppendLog(log, L"  ... and " + std::to_wstring(r.errors.size() - 10) + L" more.");
+}
+
+struct CopyJob {
+    std::filesystem::path src;
+    std::filesystem::path dst;
+    unsigned long long size{0};
+};
+
+struct VolumeCopyInfo {
+    bool sameVolume{false};
+    bool blockClone{false};
+    DWORD clusterSize{4096};
+};
+
+static std::wstring VolumeOf(const std::filesystem::path& p) {
+    wchar_t vol[MAX_PATH];
+    if (!GetVolumePathNameW(p.wstring().c_str(), vol, MAX_PATH)) return L"";
+    return vol;
+}
+
+static VolumeCopyInfo ProbeCopyVolumes(const std::filesystem::path& src, const std::filesystem::path& dst) {
+    VolumeCopyInfo info;
+    std::wstring sv = VolumeOf(src), dv = VolumeOf(dst);
+    info.sameVolume = !sv.empty() && CaseInsensitiveEquals(sv, dv);
+    DWORD flags = 0;
+    if (info.sameVolume && GetVolumeInformationW(dv.c_str(), nullptr, 0, nullptr, nullptr, &flags, nullptr, 0)) {
+        info.blockClone = (flags & FILE_SUPPORTS_BLOCK_REFCOUNTING) != 0;
+    }
+    DWORD sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, totalClusters = 0;
+    if (!dv.empty() && GetDiskFreeSpaceW(dv.c_str(), &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters)) {
+        info.clusterSize = sectorsPerCluster * bytesPerSector;
+    }
+    return info;
+}
+
+static bool CloneFileBlocks(const std::filesystem::path& src, const std::filesystem::path& dst,
+                            unsigned long long size, DWORD clusterSize) {
+    HANDLE in = CreateFileW(src.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (in == INVALID_HANDLE_VALUE) return false;
+    HANDLE out = CreateFileW(dst.wstring().c_str(), GENERIC_READ | GENERIC_WRITE | DELETE, 0, nullptr, CREATE_ALWAYS, 0, nullptr);
+    if (out == INVALID_HANDLE_VALUE) {
+        CloseHandle(in);
+        return false;
+    }
+    LARGE_INTEGER eof{};
+    eof.QuadPart = (LONGLONG)size;
+    bool ok = SetFilePointerEx(out, eof, nullptr, FILE_BEGIN) && SetEndOfFile(out);
+    const unsigned long long kMaxCloneChunk = 1ull << 30;
+    for (unsigned long long off = 0; ok && off < size; off += kMaxCloneChunk) {
+        unsigned long long len = (std::min)(kMaxCloneChunk, size - off);
+        len = (len + clusterSize - 1) / clusterSize * clusterSize;
+        DUPLICATE_EXTENTS_DATA d{};
+        d.FileHandle = in;
+        d.SourceFileOffset.QuadPart = (LONGLONG)off;
+        d.TargetFileOffset.QuadPart = (LONGLONG)off;
+        d.ByteCount.QuadPart = (LONGLONG)len;
+        DWORD returned = 0;
+        ok = DeviceIoControl(out, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &d, sizeof(d), nullptr, 0, &returned, nullptr) != 0;
+    }
+    CloseHandle(in);
+    CloseHandle(out);
+    if (!ok) {
+        std::error_code ec;
+        std::filesystem::remove(dst, ec);
+    }
+    return ok;
+}
+
+struct CopyProgressState {
+    std::atomic<unsigned long long>* done;
+    unsigned long long lastSeen;
+    const std::function<void(unsigned long long)>* tick;
+};
+
+static DWORD CALLBACK BulkCopyProgressRoutine(LARGE_INTEGER, LARGE_INTEGER transferred, LARGE_INTEGER, LARGE_INTEGER,
+                                              DWORD, DWORD, HANDLE, HANDLE, LPVOID data) {
+    auto* st = (CopyProgressState*)data;
+    unsigned long long now = (unsigned long long)transferred.QuadPart;
+    if (now > st->lastSeen) {
+        unsigned long long total = (*st->done += now - st->lastSeen);
+        st->lastSeen = now;
+        if (*st->tick) (*st->tick)(total);
+    }
+    return g_cancelRequested.load() ? PROGRESS_CANCEL : PROGRESS_CONTINUE;
+}
+
+static BulkCopyReport BulkCopy(const std::vector<CopyJob>& jobs,
+                               const std::function<void(unsigned long long, unsigned long long)>& progress = {}) {
+    const unsigned long long kUnbufferedThreshold = 64ull * 1024 * 1024;
+    TraceScope trace(L"copy", L"bulk");
+    BulkCopyReport report;
+    report.files = jobs.size();
+    if (jobs.empty()) return report;
+
+    unsigned long long total = 0;
+    for (const auto& j : jobs) total += j.size;
+    VolumeCopyInfo vol = ProbeCopyVolumes(jobs.front().src.parent_path(), jobs.front().dst.parent_path());
+
+    std::atomic<unsigned long long> done{0};
+    std::mutex m;
+    auto lastReport = std::chrono::steady_clock::now();
+    std::function<void(unsigned long long)> tick = [&](unsigned long long now) {
+        if (!progress) return;
+        std::lock_guard<std::mutex> g(m);
+        auto t = std::chrono::steady_clock::now();
+        if (t - lastReport < std::chrono::milliseconds(250) && now < total) return;
+        lastReport = t;
+        progress(now, total);
+    };
+
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return jobs[a].size > jobs[b].size; });
+
+    size_t threads = (std::min)((size_t)8, (size_t)(std::max)(4u, std::thread::hardware_concurrency()));
+    ParallelFor(order.size(), threads, [&](size_t k) {
+        const CopyJob& job = jobs[order[k]];
+        std::error_code ec;
+        std::filesystem::create_directories(job.dst.parent_path(), ec);
+        bool ok = false;
+        bool cloned = false;
+        if (vol.blockClone && job.size > 0) {
+            cloned = ok = CloneFileBlocks(job.src, job.dst, job.size, vol.clusterSize);
+            if (ok) tick(done += job.size);
+        }
+        if (!ok) {
+            CopyProgressState st{ &done, 0, &tick };
+            DWORD flags = job.size >= kUnbufferedThreshold ? COPY_FILE_NO_BUFFERING : 0;
+            ok = CopyFileExW(job.src.wstring().c_str(), job.dst.wstring().c_str(), BulkCopyProgressRoutine, &st, nullptr, flags) != 0;
+            if (ok && st.lastSeen < job.size) tick(done += job.size - st.lastSeen);
+        }
+        std::lock_guard<std::mutex> g(m);
+        if (ok) {
+            report.bytes += job.size;
+            if (cloned) ++report.cloned;
+        } else {
+            ++report.failed;
+            report.errors.push_back(job.src.wstring());
+        }
+    });
+    if (progress) progress(done.load(), total);
+    trace.Files(report.files);
+    trace.Bytes(report.bytes);
+    trace.Result((long long)report.failed);
+    return report;
+}
+
+static BulkCopyReport CopyTree(const std::filesystem::path& src, const std::filesystem::path& dst,
+                               const std::function<void(unsigned long long, unsigned long long)>& progress = {}) {
+    std::vector<CopyJob> jobs;
+    std::vector<std::wstring> dirs;
+    std::mutex m;
+    std::wstring base = src.wstring();
+    WalkOptions opts;
+    opts.skipCloudPlaceholders = false;
+    WalkTrees({ base }, opts, [&](const WalkEntry& e) {
+        std::wstring rel = e.path.substr(base.size() + 1);
+        std::lock_guard<std::mutex> g(m);
+        if (e.IsDirectory()) dirs.push_back(rel);
+        else jobs.push_back({ e.path, dst / rel, e.size });
+        return WalkAction::Continue;
+    });
+    std::error_code ec;
+    std::filesystem::create_directories(dst, ec);
+    for (const auto& d : dirs) std::filesystem::create_directories(dst / d, ec);
+    return BulkCopy(jobs, progress);
+}
+
+static void LogCopyReport(HWND log, const std::wstring& what, const BulkCopyReport& r) {
+    AppendLog(log, L" " + what + L": " + std::to_wstring(r.files) + L" files, " + FormatBytes(r.bytes) +
+                   (r.cloned ? L", " + std::to_wstring(r.cloned) + L" block-cloned" : std::wstring()) +
+                   (r.linked ? L", " + std::to_wstring(r.linked) + L" hard-linked" : std::wstring()) + L", " +
+                   std::to_wstring(r.failed) + L" failed.");
+    for (size_t i = 0; i < r.errors.size() && i < 10; ++i) AppendLog(log, L"  Failed: " + r.errors[i]);
+}
+
+struct DeleteReport {
+    std::wstring label;
+    size_t files{0};
+    size_t directories{0};
+    size_t failed{0};
+    unsigned long long bytes{0};
+    std::vector<std::wstring> errors;
+};
+
+static bool DeleteFileWithRetry(const std::wstring& path, DWORD attributes) {
+    if (attributes & FILE_ATTRIBUTE_READONLY) SetFileAttributesW(path.c_str(), FILE_ATTRIBUTE_NORMAL);
+    for (int attempt = 0; attempt < 6; ++attempt) {
+        if (DeleteFileW(path.c_str())) return true;
+        DWORD err = GetLastError();
+        if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) return true;
+        if (err != ERROR_SHARING_VIOLATION && err != ERROR_ACCESS_DENIED) return false;
+        if (g_cancelRequested.load()) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50 << attempt));
+    }
+    return false;
+}
+
+static bool RemoveDirectoryWithRetry(const std::wstring& path) {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        if (RemoveDirectoryW(path.c_str())) return true;
+        DWORD err = GetLastError();
+        if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) return true;
+        if (err == ERROR_ACCESS_DENIED) SetFileAttributesW(path.c_str(), FILE_ATTRIBUTE_NORMAL);
+        else if (err != ERROR_SHARING_VIOLATION && err != ERROR_DIR_NOT_EMPTY) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50 << attempt));
+    }
+    return false;
+}
+
+class Win32FileSystem : public IFileSystem {
+public:
+    WalkStats Walk(const std::vector<std::wstring>& roots, const WalkOptions& opts,
+                   const std::function<WalkAction(const WalkEntry&)>& visit) override {
+        return WalkTrees(roots, opts, visit);
+    }
+
+    bool Exists(const std::filesystem::path& p) override {
+        return GetFileAttributesW(p.wstring().c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+    bool IsDirectory(const std::filesystem::path& p) override {
+        DWORD attrs = GetFileAttributesW(p.wstring().c_str());
+        return attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY);
+    }
+
+    bool FileSize(const std::filesystem::path& p, unsigned long long& size) override {
+        std::error_code ec;
+        size = std::filesystem::file_size(p, ec);
+        return !ec;
+    }
+
+    std::vector<std::wstring> List(const std::filesystem::path& dir) override {
+        std::vector<std::wstring> names;
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator(dir, ec)) names.push_back(e.path().filename().wstring());
+        return names;
+    }
+
+    bool CreateDirectories(const std::filesystem::path& p) override {
+        std::error_code ec;
+        std::filesystem::create_directories(p, ec);
+        return !ec;
+    }
+
+    bool ReadText(const std::filesystem::path& p, std::string& data) override {
+        std::ifstream in(p, std::ios::binary);
+        if (!in) return false;
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        data = ss.str();
+        return true;
+    }
+
+    bool ReadStream(const std::filesystem::path& p, const std::function<void(const char*, size_t)>& sink) override {
+        HANDLE f = CreateFileW(p.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return false;
+        std::vector<char> buf(1024 * 1024);
+        bool ok = true;
+        for (;;) {
+            DWORD read = 0;
+            if (!ReadFile(f, buf.data(), (DWORD)buf.size(), &read, nullptr)) { ok = false; break; }
+            if (read == 0) break;
+            sink(buf.data(), read);
+        }
+        CloseHandle(f);
+        return ok;
+    }
+
+    bool WriteTextAtomic(const std::filesystem::path& p, const std::string& data) override {
+        std::filesystem::path tmp = p;
+        tmp += L".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out << data;
+            if (!out) return false;
+        }
+        return MoveFileExW(tmp.wstring().c_str(), p.wstring().c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    bool AppendText(const std::filesystem::path& p, const std::string& data) override {
+        HANDLE f = CreateFileW(p.wstring().c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return false;
+        bool ok = true;
+        for (size_t done = 0; ok && done < data.size();) {
+            DWORD chunk = (DWORD)(std::min<size_t>)(data.size() - done, 16u * 1024 * 1024), wrote = 0;
+            ok = WriteFile(f, data.data() + done, chunk, &wrote, nullptr) && wrote == chunk;
+            done += wrote;
+        }
+        CloseHandle(f);
+        return ok;
+    }
+
+    bool ReadRange(const std::filesystem::path& p, unsigned long long offset, size_t size, std::string& data) override {
+        HANDLE f = CreateFileW(p.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return false;
+        data.resize(size);
+        bool ok = true;
+        for (size_t done = 0; ok && done < size;) {
+            OVERLAPPED ov{};
+            ov.Offset = (DWORD)((offset + done) & 0xFFFFFFFFull);
+            ov.OffsetHigh = (DWORD)((offset + done) >> 32);
+            DWORD chunk = (DWORD)(std::min<size_t>)(size - done, 16u * 1024 * 1024), read = 0;
+            ok = ReadFile(f, &data[done], chunk, &read, &ov) && read == chunk;
+            done += read;
+        }
+        CloseHandle(f);
+        return ok;
+    }
+
+    bool SetLastWrite(const std::filesystem::path& p, unsigned long long mtime) override {
+        HANDLE f = CreateFileW(p.wstring().c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                               OPEN_EXISTING, 0, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return false;
+        FILETIME ft;
+        ft.dwLowDateTime = (DWORD)(mtime & 0xFFFFFFFFull);
+        ft.dwHighDateTime = (DWORD)(mtime >> 32);
+        bool ok = SetFileTime(f, nullptr, nullptr, &ft) != 0;
+        CloseHandle(f);
+        return ok;
+    }
+
+    bool CopyFileHashed(const std::filesystem::path& src, const std::filesystem::path& dst, std::wstring& hash,
+                        unsigned long long& size, unsigned long long mtime) override {
+        return ::CopyFileHashed(src, dst, hash, size, mtime);
+    }
+
+    BulkCopyReport CopyTree(const std::filesystem::path& src, const std::filesystem::path& dst) override {
+        return ::CopyTree(src, dst);
+    }
+
+    bool Rename(const std::filesystem::path& src, const std::filesystem::path& dst) override {
+        return MoveFileExW(src.wstring().c_str(), dst.wstring().c_str(), 0) != 0;
+    }
+
+    bool Replace(const std::filesystem::path& src, const std::filesystem::path& dst) override {
+        return MoveFileExW(src.wstring().c_str(), dst.wstring().c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+
+    bool HardLink(const std::filesystem::path& existing, const std::filesystem::path& link) override {
+        return CreateHardLinkW(link.wstring().c_str(), existing.wstring().c_str(), nullptr) != 0;
+    }
+
+    unsigned LinkCount(const std::filesystem::path& p) override {
+        HANDLE f = CreateFileW(p.wstring().c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return 0;
+        BY_HANDLE_FILE_INFORMATION info{};
+        bool ok = GetFileInformationByHandle(f, &info) != 0;
+        CloseHandle(f);
+        return ok ? info.nNumberOfLinks : 0;
+    }
+
+    bool RemoveFile(const std::filesystem::path& p, DWORD attributes) override {
+        return DeleteFileWithRetry(p.wstring(), attributes);
+    }
+
+    bool RemoveEmptyDirectory(const std::filesystem::path& p) override {
+        return RemoveDirectoryWithRetry(p.wstring());
+    }
+
+    void RemoveAll(const std::filesystem::path& p) override {
+        std::error_code ec;
+        std::filesystem::remove_all(p, ec);
+    }
+};
+
+class MemoryFileSystem : public IFileSystem {
+public:
+    struct Fault {
+        std::wstring op;
+        std::wstring pathContains;
+        DWORD error{ERROR_ACCESS_DENIED};
+    };
+
+    void SetLatency(std::chrono::microseconds perOperation) { latency_ = perOperation; }
+
+    void AddFault(const Fault& fault) {
+        std::lock_guard<std::mutex> g(m_);
+        faults_.push_back(fault);
+    }
+
+    void ClearFaults() {
+        std::lock_guard<std::mutex> g(m_);
+        faults_.clear();
+    }
+
+    void AddFile(const std::filesystem::path& p, std::string data, unsigned long long mtime = 1) {
+        std::lock_guard<std::mutex> g(m_);
+        MakeParents(p);
+        Put(p, NewInode(std::move(data), mtime));
+    }
+
+    WalkStats Walk(const std::vector<std::wstring>& roots, const WalkOptions& opts,
+                   const std::function<WalkAction(const WalkEntry&)>& visit) override {
+        WalkStats stats;
+        for (const auto& root : roots) {
+            if (Fail(L"walk", root)) continue;
+            std::vector<std::pair<std::wstring, WalkEntry>> subtree;
+            std::wstring prefix = Key(root) + L"\\";
+            {
+                std::lock_guard<std::mutex> g(m_);
+                if (!nodes_.count(Key(root))) continue;
+                for (auto it = nodes_.lower_bound(prefix); it != nodes_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+                    const Node& node = it->second;
+                    WalkEntry e;
+                    e.path = node.path;
+                    e.name = std::filesystem::path(node.path).filename().wstring();
+                    e.attributes = node.inode ? FILE_ATTRIBUTE_NORMAL : FILE_ATTRIBUTE_DIRECTORY;
+                    e.size = node.inode ? node.inode->data.size() : 0;
+                    e.lastWrite = node.inode ? node.inode->mtime : 0;
+                    e.depth = (int)std::count(it->first.begin() + prefix.size(), it->first.end(), L'\\') + 1;
+                    subtree.emplace_back(it->first, std::move(e));
+                }
+            }
+            ++stats.directories;
+            std::vector<std::wstring> blocked;
+            for (const auto& [key, e] : subtree) {
+                bool skip = std::any_of(blocked.begin(), blocked.end(),
+                                        [&](const std::wstring& b) { return key.compare(0, b.size(), b) == 0; });
+                if (skip) continue;
+                ++stats.entries;
+                WalkAction action = visit ? visit(e) : WalkAction::Continue;
+                if (!e.IsDirectory()) continue;
+                bool descend = action == WalkAction::Continue && (opts.maxDepth < 0 || e.depth < opts.maxDepth) &&
+                               std::none_of(opts.excludeDirs.begin(), opts.excludeDirs.end(),
+                                            [&](const std::wstring& x) { return CaseInsensitiveEquals(e.name, x); });
+                if (descend) ++stats.directories;
+                else blocked.push_back(key + L"\\");
+            }
+        }
+        return stats;
+    }
+
+    bool Exists(const std::filesystem::path& p) override {
+        if (Fail(L"stat", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        return nodes_.count(Key(p)) != 0;
+    }
+
+    bool IsDirectory(const std::filesystem::path& p) override {
+        if (Fail(L"stat", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto it = nodes_.find(Key(p));
+        return it != nodes_.end() && !it->second.inode;
+    }
+
+    bool FileSize(const std::filesystem::path& p, unsigned long long& size) override {
+        if (Fail(L"stat", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(p);
+        if (!inode) return false;
+        size = inode->data.size();
+        return true;
+    }
+
+    std::vector<std::wstring> List(const std::filesystem::path& dir) override {
+        std::vector<std::wstring> names;
+        if (Fail(L"list", dir)) return names;
+        std::wstring prefix = Key(dir) + L"\\";
+        std::lock_guard<std::mutex> g(m_);
+        for (auto it = nodes_.lower_bound(prefix); it != nodes_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (it->first.find(L'\\', prefix.size()) == std::wstring::npos) {
+                names.push_back(std::filesystem::path(it->second.path).filename().wstring());
+            }
+        }
+        return names;
+    }
+
+    bool CreateDirectories(const std::filesystem::path& p) override {
+        if (Fail(L"mkdir", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        MakeParents(p / L"x");
+        return true;
+    }
+
+    bool ReadText(const std::filesystem::path& p, std::string& data) override {
+        if (Fail(L"read", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(p);
+        if (!inode) return false;
+        data = inode->data;
+        return true;
+    }
+
+    bool ReadStream(const std::filesystem::path& p, const std::function<void(const char*, size_t)>& sink) override {
+        std::string data;
+        if (!ReadText(p, data)) return false;
+        for (size_t pos = 0; pos < data.size(); pos += 64 * 1024) sink(data.data() + pos, (std::min)(data.size() - pos, (size_t)64 * 1024));
+        return true;
+    }
+
+    bool WriteTextAtomic(const std::filesystem::path& p, const std::string& data) override {
+        if (Fail(L"write", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto it = nodes_.find(Key(p));
+        if (it != nodes_.end() && !it->second.inode) return false;
+        MakeParents(p);
+        Put(p, NewInode(data, ++clock_));
+        return true;
+    }
+
+    bool AppendText(const std::filesystem::path& p, const std::string& data) override {
+        if (Fail(L"write", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto it = nodes_.find(Key(p));
+        if (it != nodes_.end() && !it->second.inode) return false;
+        if (it == nodes_.end()) {
+            MakeParents(p);
+            Put(p, NewInode(std::string(), 0));
+        }
+        auto inode = Find(p);
+        inode->data += data;
+        inode->mtime = ++clock_;
+        return true;
+    }
+
+    bool ReadRange(const std::filesystem::path& p, unsigned long long offset, size_t size, std::string& data) override {
+        if (Fail(L"read", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(p);
+        if (!inode || offset + size > inode->data.size()) return false;
+        data = inode->data.substr((size_t)offset, size);
+        return true;
+    }
+
+    bool SetLastWrite(const std::filesystem::path& p, unsigned long long mtime) override {
+        if (Fail(L"write", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(p);
+        if (!inode) return false;
+        inode->mtime = mtime;
+        return true;
+    }
+
+    bool CopyFileHashed(const std::filesystem::path& src, const std::filesystem::path& dst, std::wstring& hash,
+                        unsigned long long& size, unsigned long long mtime) override {
+        if (Fail(L"read", src) || Fail(L"write", dst)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(src);
+        if (!inode) return false;
+        Sha256 sha;
+        sha.Update(inode->data.data(), inode->data.size());
+        hash = sha.FinishHex();
+        size = inode->data.size();
+        MakeParents(dst);
+        Put(dst, NewInode(inode->data, mtime ? mtime : inode->mtime));
+        return true;
+    }
+
+    BulkCopyReport CopyTree(const std::filesystem::path& src, const std::filesystem::path& dst) override {
+        BulkCopyReport report;
+        std::wstring base = Display(src);
+        CreateDirectories(dst);
+        WalkOptions opts;
+        Walk({ base }, opts, [&](const WalkEntry& e) {
+            std::filesystem::path target = dst / e.path.substr(base.size() + 1);
+            if (e.IsDirectory()) {
+                CreateDirectories(target);
+                return WalkAction::Continue;
+            }
+            ++report.files;
+            std::wstring hash;
+            unsigned long long size = 0;
+            if (CopyFileHashed(e.path, target, hash, size, e.lastWrite)) {
+                report.bytes += size;
+            } else {
+                ++report.failed;
+                report.errors.push_back(e.path);
+            }
+            return WalkAction::Continue;
+        });
+        return report;
+    }
+
+    bool Rename(const std::filesystem::path& src, const std::filesystem::path& dst) override {
+        if (Fail(L"rename", src)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        std::wstring from = Key(src), to = Key(dst);
+        if (!nodes_.count(from) || nodes_.count(to)) {
+            SetLastError(nodes_.count(to) ? ERROR_ALREADY_EXISTS : ERROR_FILE_NOT_FOUND);
+            return false;
+        }
+        std::wstring fromDisplay = Display(src), toDisplay = Display(dst);
+        std::vector<std::pair<std::wstring, Node>> moved;
+        std::wstring prefix = from + L"\\";
+        for (auto it = nodes_.begin(); it != nodes_.end();) {
+            if (it->first == from || it->first.compare(0, prefix.size(), prefix) == 0) {
+                Node n = std::move(it->second);
+                n.path = toDisplay + n.path.substr(fromDisplay.size());
+                moved.emplace_back(to + it->first.substr(from.size()), std::move(n));
+                it = nodes_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        MakeParents(dst);
+        for (auto& kv : moved) nodes_[kv.first] = std::move(kv.second);
+        return true;
+    }
+
+    bool Replace(const std::filesystem::path& src, const std::filesystem::path& dst) override {
+        if (Fail(L"rename", src)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto from = nodes_.find(Key(src));
+        auto to = nodes_.find(Key(dst));
+        if (from == nodes_.end() || !from->second.inode || (to != nodes_.end() && !to->second.inode)) {
+            SetLastError(from == nodes_.end() ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED);
+            return false;
+        }
+        std::shared_ptr<Inode> inode = from->second.inode;
+        Erase(from);
+        MakeParents(dst);
+        Put(dst, std::move(inode));
+        return true;
+    }
+
+    bool HardLink(const std::filesystem::path& existing, const std::filesystem::path& link) override {
+        if (Fail(L"link", link)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(existing);
+        if (!inode || nodes_.count(Key(link))) return false;
+        MakeParents(link);
+        Put(link, inode);
+        return true;
+    }
+
+    unsigned LinkCount(const std::filesystem::path& p) override {
+        std::lock_guard<std::mutex> g(m_);
+        auto inode = Find(p);
+        return inode ? inode->links : 0;
+    }
+
+    bool RemoveFile(const std::filesystem::path& p, DWORD) override {
+        if (Fail(L"delete", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        auto it = nodes_.find(Key(p));
+        if (it != nodes_.end() && it->second.inode) Erase(it);
+        return true;
+    }
+
+    bool RemoveEmptyDirectory(const std::filesystem::path& p) override {
+        if (Fail(L"rmdir", p)) return false;
+        std::lock_guard<std::mutex> g(m_);
+        std::wstring key = Key(p);
+        auto next = nodes_.lower_bound(key + L"\\");
+        if (next != nodes_.end() && next->first.compare(0, key.size() + 1, key + L"\\") == 0) {
+            SetLastError(ERROR_DIR_NOT_EMPTY);
+            return false;
+        }
+        auto it = nodes_.find(key);
+        if (it != nodes_.end() && !it->second.inode) nodes_.erase(it);
+        return true;
+    }
+
+    void RemoveAll(const std::filesystem::path& p) override {
+        std::lock_guard<std::mutex> g(m_);
+        std::wstring key = Key(p);
+        for (auto it = nodes_.begin(); it != nodes_.end();) {
+            if (it->first == key || it->first.compare(0, key.size() + 1, key + L"\\") == 0) it = Erase(it);
+            else ++it;
+        }
+    }
+
+private:
+    // Hard links share one inode; links counts the directory entries naming it.
+    struct Inode {
+        std::string data;
+        unsigned long long mtime{0};
+        unsigned links{0};
+    };
+
+    struct Node {
+        std::wstring path;
+        std::shared_ptr<Inode> inode;
+    };
+
+    static std::wstring Display(const std::filesystem::path& p) {
+        std::wstring s = p.wstring();
+        std::replace(s.begin(), s.end(), L'/', L'\\');
+        while (s.size() > 1 && s.back() == L'\\') s.pop_back();
+        return s;
+    }
+
+    static std::wstring Key(const std::filesystem::path& p) {
+        std::wstring s = Display(p);
+        for (auto& c : s) c = (wchar_t)towlower(c);
+        return s;
+    }
+
+    static std::shared_ptr<Inode> NewInode(std::string data, unsigned long long mtime) {
+        auto inode = std::make_shared<Inode>();
+        inode->data = std::move(data);
+        inode->mtime = mtime;
+        return inode;
+    }
+
+    std::shared_ptr<Inode> Find(const std::filesystem::path& p) const {
+        auto it = nodes_.find(Key(p));
+        return it == nodes_.end() ? nullptr : it->second.inode;
+    }
+
+    void Put(const std::filesystem::path& p, std::shared_ptr<Inode> inode) {
+        auto it = nodes_.find(Key(p));
+        if (it != nodes_.end()) Erase(it);
+        ++inode->links;
+        nodes_[Key(p)] = Node{ Display(p), std::move(inode) };
+    }
+
+    std::map<std::wstring, Node>::iterator Erase(std::map<std::wstring, Node>::iterator it) {
+        if (it->second.inode) --it->second.inode->links;
+        return nodes_.erase(it);
+    }
+
+    void MakeParents(const std::filesystem::path& p) {
+        std::wstring display = Display(p);
+        for (size_t pos = display.find(L'\\', 1); pos != std::wstring::npos; pos = display.find(L'\\', pos + 1)) {
+            std::wstring dir = display.substr(0, pos);
+            std::wstring key = Key(dir);
+            if (!nodes_.count(key)) nodes_[key] = Node{ dir, nullptr };
+        }
+    }
+
+    bool Fail(const wchar_t* op, const std::filesystem::path& p) {
+        if (latency_.count() > 0) std::this_thread::sleep_for(latency_);
+        std::wstring path = Display(p);
+        std::lock_guard<std::mutex> g(m_);
+        for (const auto& f : faults_) {
+            if ((f.op.empty() || f.op == op) && ContainsCaseInsensitive(path, f.pathContains)) {
+                SetLastError(f.error);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::mutex m_;
+    std::map<std::wstring, Node> nodes_;
+    std::vector<Fault> faults_;
+    std::chrono::microseconds latency_{0};
+    unsigned long long clock_{1};
+};
+
+static IFileSystem*& FileSystemOverride() {
+    static IFileSystem* fs = nullptr;
+    return fs;
+}
+
+static IFileSystem& DefaultFileSystem() {
+    static Win32FileSystem real;
+    IFileSystem* fs = FileSystemOverride();
+    return fs ? *fs : real;
+}
+
+static void SetDefaultFileSystem(IFileSystem* fs) {
+    FileSystemOverride() = fs;
+}
+
+static void BackupRobloxData(HWND log) {
+    std::wstring local = GetLocalAppData();
+    if (local.empty()) {
+        AppendLog(log, L" Unable to resolve LocalAppData for backup.");
+        return;
+    }
+    IFileSystem& fs = DefaultFileSystem();
+    std::filesystem::path roblox = std::filesystem::path(local) / L"Roblox";
+    std::filesystem::path backupRoot = GetBackupRoot();
+    BackupArchive archive(fs, backupRoot);
+    LegacySnapshotStore legacy(fs, backupRoot);
+    bool migrated = true;
+    for (const wchar_t* set : { L"LocalStorage", L"rbx-storage" }) {
+        if (!legacy.HasSnapshot(set)) continue;
+        AppendLog(log, std::wstring(L"Moving ") + set + L" from the old snapshot store into the archive...");
+        ArchiveReport r = archive.Import(set, legacy);
+        LogArchiveReport(log, set, r);
+        migrated = migrated && r.failed == 0;
+    }
+    for (const wchar_t* set : { L"LocalStorage", L"rbx-storage" }) {
+        std::filesystem::path src = roblox / set;
+        if (!fs.Exists(src)) continue;
+        AppendLog(log, std::wstring(L"Backing up ") + set + L"...");
+        LogArchiveReport(log, set, archive.Backup(set, src));
+    }
+    if (!legacy.Present()) return;
+    if (migrated) {
+        AppendLog(log, L" Removing the old snapshot store; its files are now in the archive.");
+        legacy.Remove();
+    } else {
+        AppendLog(log, L" Keeping the old snapshot store because part of it could not be moved into the archive.");
+    }
+}
+
+static DeleteReport DeleteTree(IFileSystem& fs, const std::filesystem::path& root, const std::wstring& label) {
+    struct Item {
+        std::wstring path;
+        DWORD attributes;
+        unsigned long long size;
+        int depth;
+    };
+    TraceScope trace(L"delete", L"tree");
+    trace.Detail(label);
+    DeleteReport report;
+    report.label = label;
+    std::vector<Item> files, dirs;
+    std::mutex m;
+    WalkOptions opts;
+    opts.skipCloudPlaceholders = false;
+    fs.Walk({ root.wstring() }, opts, [&](const WalkEntry& e) {
+        std::lock_guard<std::mutex> g(m);
+        if (e.IsDirectory()) dirs.push_back({ e.path, e.attributes, 0, e.depth });
+        else files.push_back({ e.path, e.attributes, e.size, e.depth });
+        return WalkAction::Continue;
+    });
+
+    ParallelFor(files.size(), 0, [&](size_t i) {
+        bool ok = fs.RemoveFile(files[i].path, files[i].attributes);
+        std::lock_guard<std::mutex> g(m);
+        if (ok) {
+            ++report.files;
+            report.bytes += files[i].size;
+        } else {
+            ++report.failed;
+            report.errors.push_back(files[i].path);
+        }
+    });
+
+    std::sort(dirs.begin(), dirs.end(), [](const Item& a, const Item& b) { return a.depth > b.depth; });
+    bool filesFailed = report.failed > 0;
+    size_t level = 0;
+    while (level < dirs.size()) {
+        size_t end = level;
+        while (end < dirs.size() && dirs[end].depth == dirs[level].depth) ++end;
+        ParallelFor(end - level, 0, [&](size_t k) {
+            const Item& d = dirs[level + k];
+            bool ok = fs.RemoveEmptyDirectory(d.path);
+            std::lock_guard<std::mutex> g(m);
+            if (ok) {
+                ++report.directories;
+            } else if (!filesFailed) {
+                ++report.failed;
+                report.errors.push_back(d.path);
+            }
+        });
+        level = end;
+    }
+    if (fs.RemoveEmptyDirectory(root)) ++report.directories;
+    trace.Files(report.files);
+    trace.Bytes(report.bytes);
+    trace.Result((long long)report.failed);
+    return report;
+}
+
+static void LogDeleteReport(HWND log, const DeleteReport& r) {
+    AppendLog(log, L" " + r.label + L": deleted " + std::to_wstring(r.files) + L" files (" + FormatBytes(r.bytes) + L"), " +
+                   std::to_wstring(r.directories) + L" folders, " + std::to_wstring(r.failed) + L" failed.");
+    for (size_t i = 0; i < r.errors.size() && i < 10; ++i) AppendLog(log, L"  Could not delete: " + r.errors[i]);
+}
+
+class BackgroundDeleter {
+public:
+    explicit BackgroundDeleter(IFileSystem* fs = nullptr) : fs_(fs) {}
+    ~BackgroundDeleter() { Wait(); }
+
+    bool Tombstone(const std::filesystem::path& target, const std::wstring& label) {
+        std::filesystem::path tomb = target.parent_path() /
+            (L".zfdel-" + target.filename().wstring() + L"-" + std::to_wstring(GetTickCount64()));
+        if (!Fs().Rename(target, tomb)) return false;
+        Start(tomb, label);
+        return true;
+    }
+
+    void Start(const std::filesystem::path& tomb, const std::wstring& label) {
+        std::lock_guard<std::mutex> g(m_);
+        threads_.emplace_back([this, tomb, label]() {
+            DeleteReport r = DeleteTree(Fs(), tomb, label);
+            std::lock_guard<std::mutex> lg(m_);
+            reports_.push_back(std::move(r));
+        });
+    }
+
+    void SweepLeftovers(const std::filesystem::path& dir) {
+        for (const auto& name : Fs().List(dir)) {
+            if (name.compare(0, 7, L".zfdel-") == 0) Start(dir / name, L"Leftover " + name);
+        }
+    }
+
+    std::vector<DeleteReport> Wait() {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> g(m_);
+            threads.swap(threads_);
+        }
+        for (auto& t : threads) t.join();
+        std::lock_guard<std::mutex> g(m_);
+        std::vector<DeleteReport> out;
+        out.swap(reports_);
+        return out;
+    }
+
+private:
+    // Without an explicit file system the deleter follows DefaultFileSystem(),
+    // so an override installed after first use still applies.
+    IFileSystem& Fs() { return fs_ ? *fs_ : DefaultFileSystem(); }
+
+    IFileSystem* fs_;
+    std::mutex m_;
+    std::vector<std::thread> threads_;
+    std::vector<DeleteReport> reports_;
+};
+
+static BackgroundDeleter& DefaultBackgroundDeleter() {
+    static BackgroundDeleter deleter;
+    return deleter;
+}
+
+static void DeleteAppDataDirs(HWND log, bool keepRoblox) {
+    AppendLog(log, keepRoblox ? L"Deleting LocalAppData folders: fishstrap, bloxstrap..."
+                              : L"Deleting LocalAppData folders: Roblox, fishstrap, bloxstrap...");
+    std::wstring local = GetLocalAppData();
+    if (local.empty()) {
+        AppendLog(log, L" Unable to resolve LocalAppData.");
+        return;
+    }
+    std::vector<std::wstring> targets = {
+        (std::filesystem::path(local) / L"fishstrap").wstring(),
+        (std::filesystem::path(local) / L"bloxstrap").wstring()
+    };
+    if (!keepRoblox) targets.insert(targets.begin(), (std::filesystem::path(local) / L"Roblox").wstring());
+    IFileSystem& fs = DefaultFileSystem();
+    BackgroundDeleter& background = DefaultBackgroundDeleter();
+    background.SweepLeftovers(local);
+    for (const auto& t : targets) {
+        if (!fs.Exists(t)) {
+            AppendLog(log, L" Not found: " + t);
+            continue;
+        }
+        std::wstring label = std::filesystem::path(t).filename().wstring();
+        if (background.Tombstone(t, label)) {
+            AppendLog(log, L" Removing in background: " + t);
+            continue;
+        }
+        AppendLog(log, L" Removing: " + t);
+        LogDeleteReport(log, DeleteTree(fs, t, label));
+    }
+}
+
+static void RestoreRobloxData(HWND log) {
+    std::wstring local = GetLocalAppData();
+    if (local.empty()) {
+        AppendLog(log, L" Unable to resolve LocalAppData for restore.");
+        return;
+    }
+    IFileSystem& fs = DefaultFileSystem();
+    std::filesystem::path roblox = std::filesystem::path(local) / L"Roblox";
+    std::filesystem::path backupRoot = GetBackupRoot();
+    BackupArchive archive(fs, backupRoot);
+    LegacySnapshotStore legacy(fs, backupRoot);
+    fs.CreateDirectories(roblox);
+    for (const wchar_t* set : { L"LocalStorage", L"rbx-storage" }) {
+        std::filesystem::path dst = roblox / set;
+        if (!archive.HasArchive(set) && legacy.HasSnapshot(set)) {
+            AppendLog(log, std::wstring(L"Moving ") + set + L" from the old snapshot store into the archive...");
+            LogArchiveReport(log, set, archive.Import(set, legacy));
+        }
+        if (archive.HasArchive(set)) {
+            AppendLog(log, std::wstring(L"Restoring ") + set + L"...");
+            LogArchiveReport(log, set, archive.Restore(set, dst));
+            continue;
+        }
+        std::filesystem::path legacy = backupRoot / set;
+        if (fs.Exists(legacy)) {
+            AppendLog(log, std::wstring(L"Restoring ") + set + L" from legacy backup...");
+            LogCopyReport(log, set, fs.CopyTree(legacy, dst));
+        }
+    }
+}
+
+struct ProcessInfo {
+    DWORD pid{0};
+    DWORD parentPid{0};
+    std::wstring name;
+};
+
+struct IProcessControl {
+    virtual ~IProcessControl() = default;
+    virtual std::vector<ProcessInfo> Enumerate() = 0;
+    virtual HANDLE Open(DWORD pid) = 0;
+    virtual unsigned long long CreationTime(HANDLE process) = 0;
+    virtual bool RequestClose(DWORD pid) = 0;
+    virtual std::vector<bool> WaitForExit(const std::vector<HANDLE>& processes, DWORD timeoutMs) = 0;
+    virtual std::vector<bool> TerminateAndWait(const std::vector<HANDLE>& processes, DWORD timeoutMs) = 0;
+    virtual void Close(HANDLE process) = 0;
+};
+
+class Win32ProcessControl : public IProcessControl {
+public:
+    std::vector<ProcessInfo> Enumerate() override {
+        std::vector<ProcessInfo> out;
+        HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+        if (snap == INVALID_HANDLE_VALUE) return out;
+        PROCESSENTRY32W pe{};
+        pe.dwSize = sizeof(pe);
+        if (Process32FirstW(snap, &pe)) {
+            do {
+                out.push_back({ pe.th32ProcessID, pe.th32ParentProcessID, pe.szExeFile });
+            } while (Process32NextW(snap, &pe));
+        }
+        CloseHandle(snap);
+        return out;
+    }
+
+    HANDLE Open(DWORD pid) override {
+        return OpenProcess(PROCESS_TERMINATE | PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    }
+
+    unsigned long long CreationTime(HANDLE process) override {
+        FILETIME created{}, exited{}, kernel{}, user{};
+        if (!GetProcessTimes(process, &created, &exited, &kernel, &user)) return 0;
+        return ((unsigned long long)created.dwHighDateTime << 32) | created.dwLowDateTime;
+    }
+
+    bool RequestClose(DWORD pid) override {
+        struct Ctx {
+            DWORD pid;
+            bool posted;
+        } ctx{ pid, false };
+        EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
+            auto* c = (Ctx*)lParam;
+            DWORD owner = 0;
+            GetWindowThreadProcessId(hwnd, &owner);
+            if (owner == c->pid && IsWindowVisible(hwnd)) {
+                PostMessageW(hwnd, WM_CLOSE, 0, 0);
+                c->posted = true;
+            }
+            return TRUE;
+        }, (LPARAM)&ctx);
+        return ctx.posted;
+    }
+
+    std::vector<bool> WaitForExit(const std::vector<HANDLE>& processes, DWORD timeoutMs) override {
+        std::vector<bool> exited(processes.size(), false);
+        ULONGLONG deadline = GetTickCount64() + timeoutMs;
+        for (;;) {
+            std::vector<HANDLE> waits;
+            std::vector<size_t> index;
+            for (size_t i = 0; i < processes.size() && waits.size() < MAXIMUM_WAIT_OBJECTS; ++i) {
+                if (exited[i]) continue;
+                if (WaitForSingleObject(processes[i], 0) == WAIT_OBJECT_0) {
+                    exited[i] = true;
+                    continue;
+                }
+                waits.push_back(processes[i]);
+                index.push_back(i);
+            }
+            if (waits.empty()) return exited;
+            ULONGLONG now = GetTickCount64();
+            if (now >= deadline) return exited;
+            DWORD r = WaitForMultipleObjects((DWORD)waits.size(), waits.data(), FALSE, (DWORD)(deadline - now));
+            if (r >= WAIT_OBJECT_0 && r < WAIT_OBJECT_0 + waits.size()) exited[index[r - WAIT_OBJECT_0]] = true;
+            else if (r != WAIT_TIMEOUT) return exited;
+        }
+    }
+
+    std::vector<bool> TerminateAndWait(const std::vector<HANDLE>& processes, DWORD timeoutMs) override {
+        for (HANDLE h : processes) TerminateProcess(h, 1);
+        return WaitForExit(processes, timeoutMs);
+    }
+
+    void Close(HANDLE process) override {
+        if (process) CloseHandle(process);
+    }
+};
+
+static IProcessControl& DefaultProcessControl() {
+    static Win32ProcessControl control;
+    return control;
+}
+
+struct StopProcessesReport {
+    size_t matched{0};
+    size_t children{0};
+    size_t closedGracefully{0};
+    size_t terminated{0};
+    std::vector<std::wstring> failed;
+};
+
+static StopProcessesReport StopProcesses(IProcessControl& pc, const std::function<bool(const ProcessInfo&)>& match,
+                                         DWORD graceMs, DWORD killWaitMs) {
+    struct Target {
+        ProcessInfo info;
+        HANDLE handle;
+        bool root;
+    };
+    StopProcessesReport report;
+    DWORD self = GetCurrentProcessId();
+    std::vector<ProcessInfo> all = pc.Enumerate();
+    std::multimap<DWORD, size_t> childrenOf;
+    for (size_t i = 0; i < all.size(); ++i) childrenOf.emplace(all[i].parentPid, i);
+
+    std::vector<Target> targets;
+    std::set<DWORD> seen;
+    std::deque<std::pair<size_t, unsigned long long>> pending;
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (all[i].pid == self || !match(all[i])) continue;
+        HANDLE h = pc.Open(all[i].pid);
+        if (!h) {
+            report.failed.push_back(all[i].name + L" (" + std::to_wstring(all[i].pid) + L")");
+            continue;
+        }
+        seen.insert(all[i].pid);
+        targets.push_back({ all[i], h, true });
+        pending.emplace_back(i, pc.CreationTime(h));
+        ++report.matched;
+    }
+    while (!pending.empty()) {
+        auto [parent, parentCreated] = pending.front();
+        pending.pop_front();
+        auto range = childrenOf.equal_range(all[parent].pid);
+        for (auto it = range.first; it != range.second; ++it) {
+            const ProcessInfo& child = all[it->second];
+            if (child.pid == self || child.pid == 0 || seen.count(child.pid)) continue;
+            HANDLE h = pc.Open(child.pid);
+            if (!h) continue;
+            unsigned long long created = pc.CreationTime(h);
+            if (created && parentCreated && created < parentCreated) {
+                pc.Close(h);
+                continue;
+            }
+            seen.insert(child.pid);
+            targets.push_back({ child, h, false });
+            pending.emplace_back(it->second, created);
+            ++report.children;
+        }
+    }
+    if (targets.empty()) return report;
+
+    std::vector<HANDLE> handles;
+    for (const auto& t : targets) {
+        if (t.root) pc.RequestClose(t.info.pid);
+        handles.push_back(t.handle);
+    }
+    std::vector<bool> exited = pc.WaitForExit(handles, graceMs);
+
+    std::vector<HANDLE> survivors;
+    std::vector<size_t> survivorIndex;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (exited[i]) {
+            ++report.closedGracefully;
+        } else {
+            survivors.push_back(targets[i].handle);
+            survivorIndex.push_back(i);
+        }
+    }
+    if (!survivors.empty()) {
+        std::vector<bool> killed = pc.TerminateAndWait(survivors, killWaitMs);
+        for (size_t i = 0; i < survivors.size(); ++i) {
+            const ProcessInfo& info = targets[survivorIndex[i]].info;
+            if (killed[i]) ++report.terminated;
+            else report.failed.push_back(info.name + L" (" + std::to_wstring(info.pid) + L")");
+        }
+    }
+    for (const auto& t : targets) pc.Close(t.handle);
+    return report;
+}
+
+static void KillRobloxProcesses(HWND log) {
+    AppendLog(log, L"Closing running Roblox processes...");
+
+    static const NameMatcher names({
+        L"RobloxPlayerBeta.exe",
+        L"RobloxStudioBeta.exe",
+        L"RobloxStudioLauncherBeta.exe",
+        L"Roblox.exe",
+        L"RobloxBrowserProxy.exe",
+        L"RobloxApp.exe"
+    });
+
+    StopProcessesReport r = StopProcesses(DefaultProcessControl(), [](const ProcessInfo& p) {
+        return names.Any(p.name.c_str(), p.name.size());
+    }, 3000, 5000);
+
+    if (r.matched == 0 && r.failed.empty()) {
+        AppendLog(log, L" No Roblox processes found.");
+        return;
+    }
+    AppendLog(log, L" Found " + std::to_wstring(r.matched) + L" Roblox processes and " + std::to_wstring(r.children) +
+                   L" child processes; " + std::to_wstring(r.closedGracefully) + L" closed, " +
+                   std::to_wstring(r.terminated) + L" terminated.");
+    for (const auto& f : r.failed) AppendLog(log, L" Could not stop " + f);
+    AppendLog(log, L"Roblox processes close attempts complete.");
+}
+
+static bool EnableTokenPrivilege(const wchar_t* name) {
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+    TOKEN_PRIVILEGES tp{};
+    tp.PrivilegeCount = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool ok = LookupPrivilegeValueW(nullptr, name, &tp.Privileges[0].Luid) &&
+              AdjustTokenPrivileges(token, FALSE, &tp, sizeof(tp), nullptr, nullptr) && GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return ok;
+}
+
+static std::vector<BYTE> CurrentUserSid() {
+    std::vector<BYTE> sid;
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) return sid;
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    std::vector<BYTE> buf(size);
+    if (size && GetTokenInformation(token, TokenUser, buf.data(), size, &size)) {
+        PSID user = ((TOKEN_USER*)buf.data())->User.Sid;
+        sid.resize(GetLengthSid(user));
+        if (!CopySid((DWORD)sid.size(), sid.data(), user)) sid.clear();
+    }
+    CloseHandle(token);
+    return sid;
+}
+
+static void CountAclFailure(LPWSTR, DWORD status, PROG_INVOKE_SETTING* invoke, void* args, BOOL*) {
+    if (status != ERROR_SUCCESS) ++*(size_t*)args;
+    *invoke = ProgressInvokeOnError;
+}
+
+static DWORD GrantTreeAccess(const std::filesystem::path& root, bool resetChildren, size_t& failures) {
+    EnableTokenPrivilege(SE_TAKE_OWNERSHIP_NAME);
+    EnableTokenPrivilege(SE_RESTORE_NAME);
+    EnableTokenPrivilege(SE_BACKUP_NAME);
+    std::vector<BYTE> user = CurrentUserSid();
+    BYTE system[SECURITY_MAX_SID_SIZE], admins[SECURITY_MAX_SID_SIZE];
+    DWORD systemSize = sizeof(system), adminsSize = sizeof(admins);
+    if (user.empty() || !CreateWellKnownSid(WinLocalSystemSid, nullptr, system, &systemSize) ||
+        !CreateWellKnownSid(WinBuiltinAdministratorsSid, nullptr, admins, &adminsSize)) {
+        return GetLastError() ? GetLastError() : ERROR_INVALID_SID;
+    }
+    EXPLICIT_ACCESS_W ea[3] = {};
+    PSID sids[3] = { user.data(), system, admins };
+    for (int i = 0; i < 3; ++i) {
+        ea[i].grfAccessPermissions = GENERIC_ALL;
+        ea[i].grfAccessMode = SET_ACCESS;
+        ea[i].grfInheritance = SUB_CONTAINERS_AND_OBJECTS_INHERIT;
+        ea[i].Trustee.TrusteeForm = TRUSTEE_IS_SID;
+        ea[i].Trustee.TrusteeType = i == 0 ? TRUSTEE_IS_USER : TRUSTEE_IS_WELL_KNOWN_GROUP;
+        ea[i].Trustee.ptstrName = (LPWSTR)sids[i];
+    }
+    PACL acl = nullptr;
+    DWORD err = SetEntriesInAclW(3, ea, nullptr, &acl);
+    if (err != ERROR_SUCCESS) return err;
+    std::wstring path = root.wstring();
+    SECURITY_INFORMATION info = OWNER_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION | UNPROTECTED_DACL_SECURITY_INFORMATION;
+    if (resetChildren) {
+        err = TreeSetNamedSecurityInfoW(&path[0], SE_FILE_OBJECT, info, user.data(), nullptr, acl, nullptr,
+                                        TREE_SEC_INFO_RESET, CountAclFailure, ProgressInvokeOnError, &failures);
+    } else {
+        err = SetNamedSecurityInfoW(&path[0], SE_FILE_OBJECT, info, user.data(), nullptr, acl, nullptr);
+    }
+    LocalFree(acl);
+    return err;
+}
+
+static bool ResetDataDirectory(IFileSystem& fs, const std::filesystem::path& dir, const std::wstring& label, HWND log,
+                               const std::function<DWORD(bool resetChildren, size_t& failures)>& grantAccess) {
+    if (fs.Exists(dir)) {
+        size_t aclFailures = 0;
+        DWORD err = grantAccess(false, aclFailures);
+        if (err != ERROR_SUCCESS) AppendLog(log, L" Could not take ownership of " + label + L" (error " + std::to_wstring(err) + L").");
+        DeleteReport r = DeleteTree(fs, dir, label);
+        if (r.failed) {
+            AppendLog(log, L" " + std::to_wstring(r.failed) + L" items in " + label + L" are still locked down; resetting permissions on the whole tree...");
+            err = grantAccess(true, aclFailures);
+            if (err != ERROR_SUCCESS || aclFailures) {
+                AppendLog(log, L" Permission reset finished with error " + std::to_wstring(err) + L" and " +
+                               std::to_wstring(aclFailures) + L" failures.");
+            }
+            DeleteReport retry = DeleteTree(fs, dir, label);
+            r.files += retry.files;
+            r.directories += retry.directories;
+            r.bytes += retry.bytes;
+            r.failed = retry.failed;
+            r.errors = retry.errors;
+        }
+        LogDeleteReport(log, r);
+        if (r.failed) return false;
+    }
+    std::filesystem::path probe = dir / L".zfwrite";
+    bool writable = fs.CreateDirectories(dir) && fs.WriteTextAtomic(probe, "ok") && fs.RemoveFile(probe, 0);
+    AppendLog(log, writable ? L" " + label + L" is writable." : L" " + label + L" is still not writable.");
+    return writable;
+}
+
+static bool WriteWebView2Registry(HWND log, const std::wstring& dataDir) {
+    struct Setting {
+        const wchar_t* subkey;
+        const wchar_t* value;
+        DWORD type;
+        std::wstring text;
+        DWORD number;
+    };
+    const Setting settings[] = {
+        { L"Software\\Microsoft\\EdgeWebView\\EBWebView", L"UserDataFolder", REG_SZ, dataDir, 0 },
+        { L"Software\\Microsoft\\EdgeWebView\\EBWebView", L"EnableLogging", REG_DWORD, L"", 0 },
+        { L"Software\\Microsoft\\EdgeWebView\\EBWebView", L"AdditionalBrowserArguments", REG_SZ, L"--user-data-dir=" + dataDir, 0 },
+        { L"Software\\Microsoft\\Edge\\WebView2", L"UserDataFolder", REG_SZ, dataDir, 0 },
+        { L"Software\\Microsoft\\Edge\\WebView2", L"AllowNonAdminInstall", REG_DWORD, L"", 1 },
+        { L"Software\\Policies\\Microsoft\\Edge\\WebView2", L"UserDataDir", REG_SZ, dataDir, 0 },
+    };
+    bool ok = true;
+    for (const auto& s : settings) {
+        LONG err = s.type == REG_SZ
+            ? RegSetKeyValueW(HKEY_CURRENT_USER, s.subkey, s.value, REG_SZ, s.text.c_str(), (DWORD)((s.text.size() + 1) * sizeof(wchar_t)))
+            : RegSetKeyValueW(HKEY_CURRENT_USER, s.subkey, s.value, REG_DWORD, &s.number, sizeof(s.number));
+        if (err != ERROR_SUCCESS) {
+            AppendLog(log, std::wstring(L" Could not set ") + s.subkey + L"\\" + s.value + L" (error " + std::to_wstring(err) + L").");
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static bool RepairWebView2Data(HWND log) {
+    AppendLog(log, L"Repairing WebView2 data directory...");
+    HealthProbe runtime = DefaultHealthProbes().Get(L"webview2", 60 * 60, ProbeWebView2Runtime);
+    if (!runtime.healthy) AppendLog(log, L" WebView2 runtime check failed (" + runtime.detail + L"); Zenith may still need it installed.");
+
+    StopProcessesReport stopped = StopProcesses(DefaultProcessControl(), [](const ProcessInfo& p) {
+        return CaseInsensitiveEquals(p.name, L"Zenith.exe") || CaseInsensitiveEquals(p.name, L"luau-lsp.exe");
+    }, 2000, 5000);
+    if (stopped.matched) {
+        AppendLog(log, L" Closed " + std::to_wstring(stopped.matched) + L" Zenith processes and " +
+                       std::to_wstring(stopped.children) + L" WebView2 child processes.");
+    }
+    for (const auto& f : stopped.failed) AppendLog(log, L" Could not stop " + f);
+
+    bool ok = true;
+    std::wstring local = GetLocalAppData();
+    if (local.empty()) {
+        AppendLog(log, L" Unable to resolve LocalAppData for WebView2 repair.");
+        ok = false;
+    } else {
+        std::filesystem::path dir = std::filesystem::path(local) / L"zenith.soft" / L"EBWebView";
+        ok = ResetDataDirectory(DefaultFileSystem(), dir, L"EBWebView", log, [&](bool resetChildren, size_t& failures) {
+            return GrantTreeAccess(dir, resetChildren, failures);
+        });
+        ok = WriteWebView2Registry(log, dir.wstring()) && ok;
+    }
+    DefaultHealthProbes().Invalidate(L"webview2");
+    AppendLog(log, ok ? L" WebView2 data directory repaired." : L" WebView2 repair finished with errors.");
+    return ok;
+}
+
+static bool ShellExecuteUnelevated(const std::wstring& app, const std::wstring& params) {
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    CComPtr<IShellWindows> spShellWindows;
+    if (SUCCEEDED(hr)) hr = spShellWindows.CoCreateInstance(CLSID_ShellWindows);
+    if (FAILED(hr)) { CoUninitialize(); return false; }
+    long hwndLoc = 0;
+    CComVariant vEmpty;
+    CComPtr<IDispatch> spDisp;
+    hr = spShellWindows->FindWindowSW(&vEmpty, &vEmpty, SWC_DESKTOP, &hwndLoc, SWFO_NEEDDISPATCH, &spDisp);
+    if (FAILED(hr) || !spDisp) { CoUninitialize(); return false; }
+    CComPtr<IShellDispatch2> spShellDisp;
+    hr = spDisp->QueryInterface(IID_PPV_ARGS(&spShellDisp));
+    if (FAILED(hr) || !spShellDisp) { CoUninitialize(); return false; }
+    CComBSTR bFile(app.c_str());
+    CComVariant vArgs(params.empty() ? L"" : params.c_str());
+    CComVariant vDir(L"");
+    CComVariant vOp(L"open");
+    CComVariant vShow(SW_SHOWNORMAL);
+    hr = spShellDisp->ShellExecute(bFile, vArgs, vDir, vOp, vShow);
+    CoUninitialize();
+    return SUCCEEDED(hr);
+}
+
+static DWORD RunProcessRunAsInvoker(const std::wstring& app, const std::wstring& args) {
+    SetEnvironmentVariableW(L"__COMPAT_LAYER", L"RunAsInvoker");
+    std::wstring cmd = L"\"" + app + L"\"" + (args.empty() ? L"" : L" " + args);
+    STARTUPINFOW si{};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi{};
+    DWORD code = (DWORD)-1;
+    if (CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) {
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        GetExitCodeProcess(pi.hProcess, &code);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+    }
+    SetEnvironmentVariableW(L"__COMPAT_LAYER", nullptr);
+    return code;
+}
+
+static bool IsVersionDirName(const std::wstring& name) {
+    return name.rfind(L"version-", 0) == 0 && name.find(L'.') == std::wstring::npos;
+}
+
+static std::wstring Xxh64File(IFileSystem& fs, const std::filesystem::path& p) {
+    Xxh64 h;
+    if (!fs.ReadStream(p, [&](const char* data, size_t n) { h.Update(data, n); })) return L"";
+    return h.DigestHex();
+}
+
+static std::wstring Md5File(IFileSystem& fs, const std::filesystem::path& p) {
+    Md5 h;
+    bool ok = true;
+    if (!fs.ReadStream(p, [&](const char* data, size_t n) { ok = h.Update(data, n) && ok; }) || !ok) return L"";
+    return h.FinishHex();
+}
+
+struct ManifestEntry {
+    std::wstring rel;
+    std::wstring hash;
+};
+
+struct VerifiedFile {
+    unsigned long long size{0};
+    unsigned long long mtime{0};
+    std::wstring hash;
+};
+
+static const wchar_t* kRobloxSetupCdn = L"https://setup.rbxcdn.com/";
+
+static std::wstring ManifestKey(const std::wstring& rel) {
+    std::wstring key = rel;
+    std::replace(key.begin(), key.end(), L'/', L'\\');
+    for (auto& c : key) c = (wchar_t)towlower(c);
+    return key;
+}
+
+// rbxManifest.txt alternates a path relative to the version directory with
+// the MD5 digest of that file.
+static std::vector<ManifestEntry> ParseRbxManifest(const std::string& text) {
+    std::vector<ManifestEntry> entries;
+    std::istringstream in(text);
+    std::string line;
+    std::wstring path;
+    while (std::getline(in, line)) {
+        std::wstring w = Trim(FromUtf8(line));
+        if (w.empty()) continue;
+        bool digest = w.size() == 32 && std::all_of(w.begin(), w.end(), [](wchar_t c) { return iswxdigit(c) != 0; });
+        if (digest && !path.empty()) {
+            for (auto& c : w) c = (wchar_t)towlower(c);
+            entries.push_back({ path, w });
+            path.clear();
+        } else {
+            path = w;
+        }
+    }
+    return entries;
+}
+
+class InstallManifestStore {
+public:
+    InstallManifestStore(IFileSystem& fs, IHttpTransport& http, std::filesystem::path root)
+        : fs_(fs), http_(http), root_(std::move(root)) {}
+
+    bool Get(const std::wstring& version, std::vector<ManifestEntry>& entries) {
+        if (Load(version, entries)) return true;
+        TraceScope trace(L"integrity", L"manifest");
+        trace.Detail(version);
+        HttpRequest req;
+        req.url = std::wstring(kRobloxSetupCdn) + version + L"-rbxManifest.txt";
+        HttpResponse resp;
+        std::string body;
+        bool ok = http_.Request(req, resp, [&](const char* data, size_t n) {
+            body.append(data, n);
+            return body.size() < 16 * 1024 * 1024;
+        });
+        if (!ok || resp.status != 200) return false;
+        entries = ParseRbxManifest(body);
+        if (entries.empty()) return false;
+        std::ostringstream out;
+        out << "zfman2\n";
+        for (const auto& e : entries) out << ToUtf8(e.rel) << "\t" << ToUtf8(e.hash) << "\n";
+        fs_.CreateDirectories(root_);
+        fs_.WriteTextAtomic(PathFor(version, L".zfman"), out.str());
+        trace.Files(entries.size());
+        return true;
+    }
+
+    std::map<std::wstring, VerifiedFile> LoadVerified(const std::wstring& version) const {
+        std::map<std::wstring, VerifiedFile> verified;
+        std::string text;
+        if (!fs_.ReadText(PathFor(version, L".zfver"), text)) return verified;
+        std::istringstream in(text);
+        std::string line;
+        if (!std::getline(in, line) || line != "zfver1") return verified;
+        while (std::getline(in, line)) {
+            size_t a = line.find('\t'), b = a == std::string::npos ? a : line.find('\t', a + 1);
+            size_t c = b == std::string::npos ? b : line.find('\t', b + 1);
+            if (c == std::string::npos) continue;
+            VerifiedFile v;
+            v.size = std::strtoull(line.c_str() + a + 1, nullptr, 10);
+            v.mtime = std::strtoull(line.c_str() + b + 1, nullptr, 10);
+            v.hash = FromUtf8(line.substr(c + 1));
+            verified[FromUtf8(line.substr(0, a))] = std::move(v);
+        }
+        return verified;
+    }
+
+    void SaveVerified(const std::wstring& version, const std::map<std::wstring, VerifiedFile>& verified) {
+        std::ostringstream out;
+        out << "zfver1\n";
+        for (const auto& [key, v] : verified) {
+            out << ToUtf8(key) << "\t" << v.size << "\t" << v.mtime << "\t" << ToUtf8(v.hash) << "\n";
+        }
+        fs_.CreateDirectories(root_);
+        fs_.WriteTextAtomic(PathFor(version, L".zfver"), out.str());
+    }
+
+    void Retain(const std::wstring& version) {
+        for (const auto& name : fs_.List(root_)) {
+            std::filesystem::path file(name);
+            if (!CaseInsensitiveEquals(file.stem().wstring(), version)) fs_.RemoveFile(root_ / name, 0);
+        }
+    }
+
+private:
+    bool Load(const std::wstring& version, std::vector<ManifestEntry>& entries) const {
+        entries.clear();
+        std::string text;
+        if (!fs_.ReadText(PathFor(version, L".zfman"), text)) return false;
+        std::istringstream in(text);
+        std::string line;
+        if (!std::getline(in, line) || line != "zfman2") return false;
+        while (std::getline(in, line)) {
+            size_t tab = line.find('\t');
+            if (tab == std::string::npos) continue;
+            entries.push_back({ FromUtf8(line.substr(0, tab)), FromUtf8(line.substr(tab + 1)) });
+        }
+        return !entries.empty();
+    }
+
+    std::filesystem::path PathFor(const std::wstring& version, const wchar_t* ext) const {
+        return root_ / (version + ext);
+    }
+
+    IFileSystem& fs_;
+    IHttpTransport& http_;
+    std::filesystem::path root_;
+};
+
+struct IArtifactSource {
+    virtual ~IArtifactSource() = default;
+    virtual std::wstring Describe() const = 0;
+    virtual bool Fetch(const std::wstring& version, const std::wstring& rel, const std::filesystem::path& dest) = 0;
+};
+
+class DirectoryArtifactSource : public IArtifactSource {
+public:
+    DirectoryArtifactSource(IFileSystem& fs, std::filesystem::path root) : fs_(fs), root_(std::move(root)) {}
+
+    std::wstring Describe() const override { return root_.wstring(); }
+
+    bool Fetch(const std::wstring& version, const std::wstring& rel, const std::filesystem::path& dest) override {
+        std::wstring hash;
+        unsigned long long size = 0;
+        return fs_.CopyFileHashed(root_ / version / rel, dest, hash, size, 0);
+    }
+
+private:
+    IFileSystem& fs_;
+    std::filesystem::path root_;
+};
+
+class HttpArtifactSource : public IArtifactSource {
+public:
+    HttpArtifactSource(IHttpTransport& http, std::wstring baseUrl) : http_(http), base_(std::move(baseUrl)) {
+        while (!base_.empty() && base_.back() == L'/') base_.pop_back();
+    }
+
+    std::wstring Describe() const override { return base_; }
+
+    bool Fetch(const std::wstring& version, const std::wstring& rel, const std::filesystem::path& dest) override {
+        std::wstring path = rel;
+        std::replace(path.begin(), path.end(), L'\\', L'/');
+        return DownloadWithHttp(http_, base_ + L"/" + version + L"/" + path, dest, nullptr, nullptr);
+    }
+
+private:
+    IHttpTransport& http_;
+    std::wstring base_;
+};
+
+class LinkedVersionSource : public IArtifactSource {
+public:
+    LinkedVersionSource(IFileSystem& fs, std::filesystem::path versionsRoot) : fs_(fs), root_(std::move(versionsRoot)) {}
+
+    std::wstring Describe() const override { return L"other versions in " + root_.wstring(); }
+
+    bool Fetch(const std::wstring& version, const std::wstring& rel, const std::filesystem::path& dest) override {
+        for (const auto& name : fs_.List(root_)) {
+            if (!IsVersionDirName(name) || CaseInsensitiveEquals(name, version)) continue;
+            if (fs_.Exists(root_ / name / rel) && fs_.HardLink(root_ / name / rel, dest)) return true;
+        }
+        return false;
+    }
+
+private:
+    IFileSystem& fs_;
+    std::filesystem::path root_;
+};
+
+static std::vector<std::unique_ptr<IArtifactSource>> DefaultArtifactSources(const std::filesystem::path& versionsRoot) {
+    std::vector<std::unique_ptr<IArtifactSource>> sources;
+    sources.push_back(std::make_unique<LinkedVersionSource>(DefaultFileSystem(), versionsRoot));
+    sources.push_back(std::make_unique<DirectoryArtifactSource>(DefaultFileSystem(), ActiveFixPaths().programFilesVersions));
+    std::wstring url = GetEnv(L"ZENITHFIXER_ARTIFACT_URL");
+    if (!url.empty()) sources.push_back(std::make_unique<HttpArtifactSource>(DefaultHttpTransport(), url));
+    return sources;
+}
+
+struct VerifyReport {
+    size_t files{0};
+    size_t unchanged{0};
+    size_t mismatched{0};
+    size_t repaired{0};
+    size_t failed{0};
+    unsigned long long bytesHashed{0};
+    std::vector<std::wstring> errors;
+};
+
+// Files whose size and last-write time match an earlier successful check are
+// not hashed again; only new or changed files are read.
+static VerifyReport VerifyAndRepairInstall(IFileSystem& fs, const std::filesystem::path& dir, const std::wstring& version,
+                                           const std::vector<ManifestEntry>& manifest,
+                                           std::map<std::wstring, VerifiedFile>& verified,
+                                           const std::vector<std::unique_ptr<IArtifactSource>>& sources) {
+    TraceScope trace(L"integrity", L"verify");
+    trace.Detail(version);
+    VerifyReport report;
+    report.files = manifest.size();
+    std::mutex m;
+    std::map<std::wstring, WalkEntry> onDisk;
+    std::wstring base = dir.wstring();
+    WalkOptions opts;
+    opts.skipCloudPlaceholders = false;
+    fs.Walk({ base }, opts, [&](const WalkEntry& w) {
+        if (w.IsDirectory()) return WalkAction::Continue;
+        std::lock_guard<std::mutex> g(m);
+        onDisk[ManifestKey(w.path.substr(base.size() + 1))] = w;
+        return WalkAction::Continue;
+    });
+
+    std::vector<VerifiedFile> fresh(manifest.size());
+    std::vector<size_t> bad;
+    ParallelFor(manifest.size(), 0, [&](size_t i) {
+        const ManifestEntry& e = manifest[i];
+        std::wstring key = ManifestKey(e.rel);
+        auto disk = onDisk.find(key);
+        bool ok = false, cached = false;
+        if (disk != onDisk.end()) {
+            auto last = verified.find(key);
+            cached = last != verified.end() && last->second.size == disk->second.size &&
+                     last->second.mtime == disk->second.lastWrite && last->second.hash == e.hash;
+            ok = cached || Md5File(fs, disk->second.path) == e.hash;
+            if (ok && !cached) fresh[i] = { disk->second.size, disk->second.lastWrite, e.hash };
+        }
+        std::lock_guard<std::mutex> g(m);
+        if (cached) ++report.unchanged;
+        else if (disk != onDisk.end()) report.bytesHashed += disk->second.size;
+        if (!ok) bad.push_back(i);
+    });
+    for (size_t i = 0; i < manifest.size(); ++i) {
+        if (!fresh[i].hash.empty()) verified[ManifestKey(manifest[i].rel)] = fresh[i];
+    }
+    for (size_t i : bad) verified.erase(ManifestKey(manifest[i].rel));
+    report.mismatched = bad.size();
+
+    ParallelFor(bad.size(), 4, [&](size_t k) {
+        const ManifestEntry& e = manifest[bad[k]];
+        std::filesystem::path target = dir / e.rel;
+        std::filesystem::path staging = target;
+        staging += L".zfrepair";
+        fs.CreateDirectories(target.parent_path());
+        bool repaired = false;
+        for (const auto& source : sources) {
+            if (g_cancelRequested.load()) break;
+            fs.RemoveFile(staging, 0);
+            if (!source->Fetch(version, e.rel, staging) || Md5File(fs, staging) != e.hash) continue;
+            fs.RemoveFile(target, FILE_ATTRIBUTE_READONLY);
+            repaired = fs.Rename(staging, target);
+            if (repaired) break;
+        }
+        fs.RemoveFile(staging, 0);
+        std::lock_guard<std::mutex> g(m);
+        if (repaired) {
+            ++report.repaired;
+        } else {
+            ++report.failed;
+            report.errors.push_back(e.rel);
+        }
+    });
+    trace.Files(report.files - report.unchanged);
+    trace.Bytes(report.bytesHashed);
+    trace.Result((long long)report.failed);
+    return report;
+}
+
+static BulkCopyReport CopyTreeReusing(IFileSystem& fs, const std::filesystem::path& src, const std::filesystem::path& dst,
+                                      const std::filesystem::path& previous) {
+    TraceScope trace(L"fs", L"copy-reuse");
+    BulkCopyReport report;
+    std::mutex m;
+    std::vector<WalkEntry> files;
+    std::wstring base = src.wstring();
+    WalkOptions opts;
+    opts.skipCloudPlaceholders = false;
+    fs.CreateDirectories(dst);
+    fs.Walk({ base }, opts, [&](const WalkEntry& e) {
+        if (e.IsDirectory()) {
+            fs.CreateDirectories(dst / e.path.substr(base.size() + 1));
+            return WalkAction::Continue;
+        }
+        std::lock_guard<std::mutex> g(m);
+        files.push_back(e);
+        return WalkAction::Continue;
+    });
+    ParallelFor(files.size(), 0, [&](size_t i) {
+        const WalkEntry& e = files[i];
+        std::wstring rel = e.path.substr(base.size() + 1);
+        std::filesystem::path old = previous / rel;
+        std::filesystem::path target = dst / rel;
+        unsigned long long size = 0;
+        std::wstring oldHash;
+        bool linked = fs.FileSize(old, size) && size == e.size && !(oldHash = Xxh64File(fs, old)).empty() &&
+                      oldHash == Xxh64File(fs, e.path) && fs.HardLink(old, target);
+        std::wstring hash;
+        bool ok = linked || fs.CopyFileHashed(e.path, target, hash, size, e.lastWrite);
+        std::lock_guard<std::mutex> g(m);
+        ++report.files;
+        if (linked) ++report.linked;
+        if (ok) {
+            report.bytes += size;
+        } else {
+            ++report.failed;
+            report.errors.push_back(e.path);
+        }
+    });
+    trace.Files(report.files);
+    trace.Bytes(report.bytes);
+    return report;
+}
+
+static void LogVerifyReport(HWND log, const VerifyReport& r) {
+    AppendLog(log, L" Verified " + std::to_wstring(r.files) + L" files (" + std::to_wstring(r.unchanged) +
+                   L" unchanged since the last check, " + FormatBytes(r.bytesHashed) + L" hashed): " +
+                   std::to_wstring(r.mismatched) + L" damaged, " + std::to_wstring(r.repaired) + L" repaired, " +
+                   std::to_wstring(r.failed) + L" could not be repaired.");
+    for (size_t i = 0; i < r.errors.size() && i < 10; ++i) AppendLog(log, L"  Unrepaired: " + r.errors[i]);
+    if (r.errors.size() > 10) AppendLog(log, L"  ... and " + std::to_wstring(r.errors.size() - 10) + L" more.");
+}
+
+static const wchar_t* kRobloxVersionFeed = L"https://clientsettingscdn.roblox.com/v2/client-version/WindowsPlayer";
+
+static std::wstring ParseClientVersionUpload(const std::string& json) {
+    const std::string key = "\"clientVersionUpload\"";
+    size_t at = json.find(key);
+    if (at == std::string::npos) return L"";
+    size_t open = json.find('"', json.find(':', at + key.size()));
+    size_t close = open == std::string::npos ? std::string::npos : json.find('"', open + 1);
+    if (close == std::string::npos) return L"";
+    std::wstring version = FromUtf8(json.substr(open + 1, close - open - 1));
+    return version.rfind(L"version-", 0) == 0 ? version : L"";
+}
+
+static std::wstring FetchRobloxClientVersion() {
+    HttpRequest req;
+    req.url = kRobloxVersionFeed;
+    HttpResponse resp;
+    std::string body;
+    bool ok = DefaultHttpTransport().Request(req, resp, [&](const char* data, size_t n) {
+        body.append(data, n);
+        return body.size() < 64 * 1024;
+    });
+    return ok ? ParseClientVersionUpload(body) : L"";
+}
+
+// The feed answer is kept for an hour in its own file next to the health
+// cache; only a parsed version string is ever written.
+static std::wstring LatestRobloxVersion() {
+    const long long kMaxAgeSeconds = 60 * 60;
+    IFileSystem& fs = DefaultFileSystem();
+    std::filesystem::path file = GetBackupRoot() / L"RobloxVersion.cache";
+    std::string text;
+    if (fs.ReadText(file, text)) {
+        std::istringstream in(text);
+        std::string magic, version, fetched;
+        if (std::getline(in, magic) && magic == "zfrv1" && std::getline(in, version) && std::getline(in, fetched) &&
+            version.rfind("version-", 0) == 0 && UnixNow() - std::atoll(fetched.c_str()) < kMaxAgeSeconds) {
+            return FromUtf8(version);
+        }
+    }
+    std::wstring version = FetchRobloxClientVersion();
+    if (!version.empty()) fs.WriteTextAtomic(file, "zfrv1\n" + ToUtf8(version) + "\n" + std::to_string(UnixNow()) + "\n");
+    return version;
+}
+
+static std::wstring BundledRobloxVersion() {
+    wchar_t exe[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, exe, MAX_PATH)) return L"";
+    std::string text;
+    if (!DefaultFileSystem().ReadText(std::filesystem::path(exe).parent_path() / L"Current roblox version.txt", text)) return L"";
+    std::wstring version = Trim(FromUtf8(text));
+    return version.rfind(L"version-", 0) == 0 ? version : L"";
+}
+
+static std::wstring ExpectedRobloxVersion(std::wstring& source) {
+    std::wstring latest = LatestRobloxVersion();
+    if (!latest.empty()) {
+        source = L"version feed";
+        return latest;
+    }
+    source = L"bundled version file";
+    return BundledRobloxVersion();
+}
+
+struct RobloxInstallStatus {
+    std::wstring expected;
+    std::vector<std::wstring> installed;
+    std::vector<std::wstring> missing;
+    std::filesystem::path dir;
+    bool present{false};
+    bool current{false};
+};
+
+static RobloxInstallStatus CheckRobloxInstall(IFileSystem& fs, const std::filesystem::path& versionsDir, const std::wstring& expected) {
+    static const wchar_t* kKeyFiles[] = { L"RobloxPlayerBeta.exe", L"RobloxPlayerBeta.dll", L"RobloxCrashHandler.exe", L"AppSettings.xml" };
+    RobloxInstallStatus s;
+    s.expected = expected;
+    for (const auto& name : fs.List(versionsDir)) {
+        if (IsVersionDirName(name) && fs.IsDirectory(versionsDir / name)) s.installed.push_back(name);
+    }
+    for (const auto& name : s.installed) {
+        if (fs.Exists(versionsDir / name / L"RobloxPlayerBeta.exe")) s.present = true;
+    }
+    auto match = std::find_if(s.installed.begin(), s.installed.end(),
+                              [&](const std::wstring& n) { return CaseInsensitiveEquals(n, expected); });
+    if (expected.empty() || match == s.installed.end()) return s;
+    s.dir = versionsDir / *match;
+    for (const wchar_t* f : kKeyFiles) {
+        unsigned long long size = 0;
+        if (!fs.FileSize(s.dir / f, size) || size == 0) s.missing.push_back(f);
+    }
+    if (!fs.IsDirectory(s.dir / L"content")) s.missing.push_back(L"content");
+    s.current = s.missing.empty();
+    return s;
+}
+
+static bool RobloxIsCurrent(HWND log, std::wstring& expected) {
+    AppendLog(log, L"Checking installed Roblox version...");
+    std::wstring local = GetLocalAppData();
+    if (local.empty()) {
+        AppendLog(log, L" Unable to resolve LocalAppData; Roblox will be reinstalled.");
+        return false;
+    }
+    std::wstring source;
+    expected = ExpectedRobloxVersion(source);
+    if (expected.empty()) {
+        AppendLog(log, L" Could not determine the current Roblox version; Roblox will be reinstalled.");
+        return false;
+    }
+    IFileSystem& fs = DefaultFileSystem();
+    std::filesystem::path versionsRoot = std::filesystem::path(local) / L"Roblox" / L"Versions";
+    RobloxInstallStatus s = CheckRobloxInstall(fs, versionsRoot, expected);
+    AppendLog(log, L" Expected " + expected + L" (from " + source + L").");
+    if (!s.dir.empty()) {
+        InstallManifestStore manifests(fs, DefaultHttpTransport(), GetBackupRoot() / L"Manifests");
+        std::vector<ManifestEntry> manifest;
+        if (manifests.Get(expected, manifest)) {
+            manifests.Retain(expected);
+            AppendLog(log, L" Verifying Roblox " + expected + L" against its deployment manifest...");
+            std::map<std::wstring, VerifiedFile> verified = manifests.LoadVerified(expected);
+            VerifyReport v = VerifyAndRepairInstall(fs, s.dir, expected, manifest, verified, DefaultArtifactSources(versionsRoot));
+            manifests.SaveVerified(expected, verified);
+            LogVerifyReport(log, v);
+            if (v.failed == 0) {
+                AppendLog(log, L" Roblox " + expected + L" is installed and intact; skipping reinstall.");
+                return true;
+            }
+            AppendLog(log, L" Roblox " + expected + L" could not be repaired in place; Roblox will be reinstalled.");
+            return false;
+        }
+        AppendLog(log, L" No deployment manifest available for " + expected + L"; checking key files only.");
+    }
+    if (s.current) {
+        AppendLog(log, L" Roblox " + expected + L" is installed and intact; skipping reinstall.");
+        return true;
+    }
+    if (!s.missing.empty()) {
+        std::wstring list;
+        for (const auto& m : s.missing) list += (list.empty() ? L"" : L", ") + m;
+        AppendLog(log, L" Roblox " + expected + L" is corrupt (missing " + list + L"); Roblox will be reinstalled.");
+    } else if (s.present) {
+        AppendLog(log, L" Installed Roblox is stale (" + s.installed.back() + L"); Roblox will be reinstalled.");
+    } else {
+        AppendLog(log, L" Roblox is not installed; Roblox will be installed.");
+    }
+    return false;
+}
+
+static bool DownloadRobloxInstaller(HWND log, std::filesystem::path& dest, const std::function<void(int)>& report) {
+    AppendLog(log, L"Downloading Roblox installer to LocalAppData, this may take long depending on your pc...");
+    dest = std::filesystem::path(GetLocalTemp()) / L"RobloxPlayerInstaller.exe";
+    if (!DownloadFile(L"https://www.roblox.com/download/client?os=win", dest, log, report)) {
+        AppendLog(log, L" Failed to download Roblox installer.");
+        return false;
+    }
+    return true;
+}
+
+static bool InstallRobloxToLocalAppData(HWND log, const std::filesystem::path& installer) {
+    AppendLog(log, L"Launching Roblox installer unelevated (per-user)...");
+    bool launched = ShellExecuteUnelevated(installer.wstring(), L"");
+    DWORD exitCode = 0;
+    if (!launched) {
+        AppendLog(log, L" Shell launch failed; retrying with RunAsInvoker...");
+        exitCode = RunProcessRunAsInvoker(installer.wstring(), L"");
+        launched = (exitCode != (DWORD)-1);
+    }
+    if (!launched) {
+        AppendLog(log, L" Could not start the installer. Please run it manually from LocalAppData\\Temp.");
+        return false;
+    }
+    AppendLog(log, L"Roblox installer started. Complete the UI to finish the per-user install.");
+    return true;
+}
+
+static void OpenRobloxDownloadPage(HWND log) {
+    AppendLog(log, L"Opening Roblox client download page in default browser...");
+    ShellExecuteW(nullptr, L"open", L"https://www.roblox.com/download/client?os=win", nullptr, nullptr, SW_SHOWNORMAL);
+}
+
+static std::wstring FoldName(const std::wstring& s) {
+    std::wstring r = s;
+    for (auto& c : r) c = (wchar_t)towlower(c);
+    return r;
+}
+
+static std::unordered_set<std::wstring> SnapshotDownloads(const std::wstring& downloads) {
+    std::unordered_set<std::wstring> names;
+    std::error_code ec;
+    for (const auto& e : std::filesystem::directory_iterator(downloads, ec)) {
+        std::error_code fec;
+        if (!e.is_regular_file(fec)) continue;
+        names.insert(FoldName(e.path().filename().wstring()));
+    }
+    return names;
+}
+
+static bool SnapshotContains(const std::unordered_set<std::wstring>& snapshot, const std::wstring& filename) {
+    return snapshot.count(FoldName(filename)) != 0;
+}
+
+class DirectoryWatcher {
+public:
+    explicit DirectoryWatcher(const std::wstring& dir) : buf_(16 * 1024) {
+        dir_ = CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (dir_ == INVALID_HANDLE_VALUE) dir_ = nullptr;
+        ov_.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (dir_ && ov_.hEvent) Arm();
+    }
+
+    ~DirectoryWatcher() {
+        if (dir_) {
+            if (armed_) {
+                CancelIoEx(dir_, &ov_);
+                DWORD n = 0;
+                GetOverlappedResult(dir_, &ov_, &n, TRUE);
+            }
+            CloseHandle(dir_);
+        }
+        if (ov_.hEvent) CloseHandle(ov_.hEvent);
+    }
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    bool Wait(DWORD timeoutMs, std::vector<std::pair<DWORD, std::wstring>>& changes, bool& rescan) {
+        rescan = false;
+        if (!armed_ && !Arm()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            rescan = true;
+            return true;
+        }
+        if (WaitForSingleObject(ov_.hEvent, timeoutMs) != WAIT_OBJECT_0) return true;
+        DWORD bytes = 0;
+        armed_ = false;
+        if (!GetOverlappedResult(dir_, &ov_, &bytes, FALSE)) {
+            rescan = true;
+            return Arm();
+        }
+        std::vector<DWORD> data(buf_.begin(), buf_.begin() + (bytes + sizeof(DWORD) - 1) / sizeof(DWORD));
+        Arm();
+        if (bytes == 0) {
+            rescan = true;
+            return true;
+        }
+        const unsigned char* p = (const unsigned char*)data.data();
+        for (;;) {
+            const auto* info = (const FILE_NOTIFY_INFORMATION*)p;
+            changes.emplace_back(info->Action, std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+            if (info->NextEntryOffset == 0) break;
+            p += info->NextEntryOffset;
+        }
+        return true;
+    }
+
+private:
+    bool Arm() {
+        if (!dir_ || !ov_.hEvent) return false;
+        ResetEvent(ov_.hEvent);
+        armed_ = ReadDirectoryChangesW(dir_, buf_.data(), (DWORD)(buf_.size() * sizeof(DWORD)), FALSE,
+                                       FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                       nullptr, &ov_, nullptr) != 0;
+        return armed_;
+    }
+
+    HANDLE dir_{};
+    OVERLAPPED ov_{};
+    std::vector<DWORD> buf_;
+    bool armed_{false};
+};
+
+static bool IsFileSettled(const std::filesystem::path& p) {
+    HANDLE h = CreateFileW(p.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    CloseHandle(h);
+    return true;
+}
+
+static std::wstring WaitForNewStableFile(const std::wstring& dir, const std::function<bool(const std::wstring&)>& accept,
+                                         std::chrono::steady_clock::time_point deadline,
+                                         std::chrono::milliseconds settle = std::chrono::milliseconds(1000)) {
+    struct Candidate {
+        unsigned long long size{(unsigned long long)-1};
+        std::chrono::steady_clock::time_point since;
+    };
+    DirectoryWatcher watcher(dir);
+    std::unordered_set<std::wstring> baseline = SnapshotDownloads(dir);
+    std::map<std::wstring, Candidate> candidates;
+
+    auto consider = [&](const std::wstring& name) {
+        if (!accept(name) || SnapshotContains(baseline, name)) return;
+        candidates.emplace(name, Candidate{ (unsigned long long)-1, std::chrono::steady_clock::now() });
+    };
+
+    while (std::chrono::steady_clock::now() < deadline && !g_cancelRequested.load()) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        DWORD timeout = (DWORD)(std::min<long long>)(remaining.count(), candidates.empty() ? 1000 : 200);
+        std::vector<std::pair<DWORD, std::wstring>> changes;
+        bool rescan = false;
+        watcher.Wait((std::max)(timeout, (DWORD)1), changes, rescan);
+        for (const auto& c : changes) {
+            if (c.first == FILE_ACTION_REMOVED || c.first == FILE_ACTION_RENAMED_OLD_NAME) candidates.erase(c.second);
+            else consider(c.second);
+        }
+        if (rescan) {
+            std::error_code ec;
+            for (const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+                std::error_code fec;
+                if (e.is_regular_file(fec)) consider(e.path().filename().wstring());
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = candidates.begin(); it != candidates.end();) {
+            std::filesystem::path full = std::filesystem::path(dir) / it->first;
+            std::error_code ec;
+            unsigned long long size = std::filesystem::file_size(full, ec);
+            if (ec) {
+                it = candidates.erase(it);
+                continue;
+            }
+            if (size != it->second.size) {
+                it->second.size = size;
+                it->second.since = now;
+            } else if (size > 0 && now - it->second.since >= settle && IsFileSettled(full)) {
+                return full.wstring();
+            }
+            ++it;
+        }
+    }
+    return L"";
+}
+
+static std::wstring WaitForRobloxExeInDownloads(HWND log, int maxSeconds = 300) {
+    std::wstring downloads = GetDownloadsPath();
+    if (downloads.empty()) {
+        AppendLog(log, L" Downloads folder not resolved; cannot watch for installer.");
+        return L"";
+    }
+    AppendLog(log, L"Waiting up to " + std::to_wstring(maxSeconds) + L"s for a new 'roblox*.exe' in Downloads...");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(maxSeconds);
+    static const NameMatcher installerNames({ L".crdownload", L".download", L".part", L"roblox", L".exe" });
+    const unsigned kPartialDownload = 0x7;
+    const unsigned kInstaller = 0x18;
+    std::wstring found = WaitForNewStableFile(downloads, [&](const std::wstring& fname) {
+        unsigned hit = installerNames.Match(fname);
+        return (hit & kPartialDownload) == 0 && (hit & kInstaller) == kInstaller;
+    }, deadline);
+    if (!found.empty()) {
+        AppendLog(log, L" Found new installer: " + std::filesystem::path(found).filename().wstring());
+        return found;
+    }
+    AppendLog(log, L" Timed out waiting for Roblox installer in Downloads.");
+    return L"";
+}
+
+static void RunRobloxInstaller(HWND log, const std::wstring& path) {
+    AppendLog(log, L"Launching Roblox installer: " + path);
+    DWORD code = RunProcessWait(path, L"", false);
+    AppendLog(log, L" Roblox installer exit code " + std::to_wstring(code));
+}
+
+static void AttemptCloseRobloxTab(HWND log) {
+    CloseRobloxBrowserTabs(log);
+}
+
+static bool AppendDurableLine(const std::filesystem::path& file, const std::wstring& line) {
+    HANDLE h = CreateFileW(file.wstring().c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    std::string data = ToUtf8(line) + "\n";
+    DWORD wrote = 0;
+    bool ok = WriteFile(h, data.data(), (DWORD)data.size(), &wrote, nullptr) && wrote == data.size();
+    ok = FlushFileBuffers(h) && ok;
+    CloseHandle(h);
+    return ok;
+}
+
+static std::vector<std::pair<std::wstring, std::wstring>> ReadJournal(const std::filesystem::path& file) {
+    std::vector<std::pair<std::wstring, std::wstring>> records;
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t sp = line.find(' ');
+        if (sp == std::string::npos) continue;
+        records.emplace_back(FromUtf8(line.substr(0, sp)), FromUtf8(line.substr(sp + 1)));
+    }
+    return records;
+}
+
+static bool TreeMatches(IFileSystem& fs, const std::filesystem::path& a, const std::filesystem::path& b) {
+    std::map<std::wstring, unsigned long long> left, right;
+    std::mutex m;
+    auto collect = [&](const std::filesystem::path& root, std::map<std::wstring, unsigned long long>& out) {
+        std::wstring base = root.wstring();
+        WalkOptions opts;
+        opts.skipCloudPlaceholders = false;
+        fs.Walk({ base }, opts, [&](const WalkEntry& e) {
+            if (!e.IsDirectory()) {
+                std::lock_guard<std::mutex> g(m);
+                out[e.path.substr(base.size() + 1)] = e.size;
+            }
+            return WalkAction::Continue;
+        });
+    };
+    collect(a, left);
+    collect(b, right);
+    return left == right;
+}
+
+class VersionsMover {
+public:
+    VersionsMover(IFileSystem& fs, std::filesystem::path src, std::filesystem::path dst, std::filesystem::path journal,
+                  std::wstring only, HWND log)
+        : fs_(fs), src_(std::move(src)), dst_(std::move(dst)), journal_(std::move(journal)), only_(std::move(only)), log_(log) {}
+
+    bool Run() {
+        std::error_code ec;
+        if (std::filesystem::exists(journal_, ec)) Recover();
+
+        std::vector<std::wstring> names = fs_.List(src_);
+        names.erase(std::remove_if(names.begin(), names.end(),
+                                   [&](const std::wstring& n) { return !CaseInsensitiveEquals(n, only_); }),
+                    names.end());
+
+        bool ok = true;
+        for (const auto& name : names) ok = MoveOne(name) && ok;
+        if (ok) {
+            std::filesystem::remove(journal_, ec);
+            fs_.RemoveEmptyDirectory(src_);
+        }
+        return ok;
+    }
+
+private:
+    std::filesystem::path Partial(const std::wstring& name) const { return dst_ / (name + L".zfpartial"); }
+    std::filesystem::path Displaced(const std::wstring& name) const { return dst_ / (name + L".zfold"); }
+
+    std::filesystem::path PreviousVersion(const std::wstring& name) const {
+        std::vector<std::wstring> names = fs_.List(dst_);
+        std::sort(names.begin(), names.end());
+        for (auto it = names.rbegin(); it != names.rend(); ++it) {
+            if (IsVersionDirName(*it) && !CaseInsensitiveEquals(*it, name) && fs_.IsDirectory(dst_ / *it)) return dst_ / *it;
+        }
+        return {};
+    }
+
+    bool MoveOne(const std::wstring& name) {
+        std::filesystem::path from = src_ / name;
+        std::filesystem::path to = dst_ / name;
+        bool displaced = false;
+        if (fs_.Exists(to)) {
+            fs_.RemoveAll(Displaced(name));
+            if (!fs_.Rename(to, Displaced(name))) {
+                AppendLog(log_, L" Cannot replace existing " + name + L"; skipping.");
+                return false;
+            }
+            displaced = true;
+        }
+
+        if (fs_.Rename(from, to)) {
+            AppendLog(log_, L" Renamed " + name + L" in place.");
+            if (displaced) fs_.RemoveAll(Displaced(name));
+            return true;
+        }
+
+        AppendDurableLine(journal_, L"begin " + name);
+        fs_.RemoveAll(Partial(name));
+        bool copied = false;
+        if (fs_.IsDirectory(from)) {
+            std::filesystem::path previous = PreviousVersion(name);
+            BulkCopyReport r = previous.empty() ? fs_.CopyTree(from, Partial(name)) : CopyTreeReusing(fs_, from, Partial(name), previous);
+            LogCopyReport(log_, name, r);
+            copied = r.failed == 0 && TreeMatches(fs_, from, Partial(name));
+        } else {
+            std::wstring hash;
+            unsigned long long size = 0;
+            copied = fs_.CopyFileHashed(from, Partial(name), hash, size, 0);
+        }
+        if (!copied) {
+            AppendLog(log_, L" Copy of " + name + L" failed verification; rolling back.");
+            RollBack(name, displaced);
+            AppendDurableLine(journal_, L"rolledback " + name);
+            return false;
+        }
+        AppendDurableLine(journal_, L"copied " + name);
+        return Commit(name);
+    }
+
+    bool Commit(const std::wstring& name) {
+        std::filesystem::path to = dst_ / name;
+        if (fs_.Exists(Partial(name))) {
+            fs_.RemoveAll(to);
+            if (!fs_.Rename(Partial(name), to)) {
+                AppendLog(log_, L" Could not finalize " + name + L"; it will be retried next run.");
+                return false;
+            }
+        }
+        fs_.RemoveAll(Displaced(name));
+        fs_.RemoveAll(src_ / name);
+        bool removed = !fs_.Exists(src_ / name);
+        if (!removed) AppendLog(log_, L" Copied " + name + L" but could not delete the source.");
+        AppendDurableLine(journal_, L"done " + name);
+        AppendLog(log_, L" Copied " + name + L" across volumes.");
+        return removed;
+    }
+
+    void RollBack(const std::wstring& name, bool displaced) {
+        fs_.RemoveAll(Partial(name));
+        if (displaced || fs_.Exists(Displaced(name))) fs_.Rename(Displaced(name), dst_ / name);
+    }
+
+    void Recover() {
+        std::map<std::wstring, std::wstring> last;
+        for (const auto& r : ReadJournal(journal_)) last[r.second] = r.first;
+        for (const auto& kv : last) {
+            if (kv.second == L"copied") {
+                AppendLog(log_, L" Resuming interrupted move of " + kv.first + L"...");
+                Commit(kv.first);
+            } else if (kv.second == L"begin") {
+                AppendLog(log_, L" Rolling back interrupted copy of " + kv.first + L"...");
+                RollBack(kv.first, false);
+                AppendDurableLine(journal_, L"rolledback " + kv.first);
+            }
+        }
+    }
+
+    IFileSystem& fs_;
+    std::filesystem::path src_;
+    std::filesystem::path dst_;
+    std::filesystem::path journal_;
+    std::wstring only_;
+    HWND log_;
+};
+
+static std::wstring ActiveRobloxVersion(IFileSystem& fs, const std::vector<std::filesystem::path>& roots, const std::wstring& expected) {
+    std::wstring newest;
+    unsigned long long newestTime = 0;
+    for (const auto& root : roots) {
+        for (const auto& name : fs.List(root)) {
+            if (!IsVersionDirName(name) || !fs.IsDirectory(root / name)) continue;
+            if (!expected.empty() && CaseInsensitiveEquals(name, expected)) return name;
+            WalkOptions opts;
+            opts.maxDepth = 1;
+            opts.skipCloudPlaceholders = false;
+            std::mutex m;
+            fs.Walk({ (root / name).wstring() }, opts, [&](const WalkEntry& e) {
+                if (!CaseInsensitiveEquals(e.name, L"RobloxPlayerBeta.exe")) return WalkAction::Continue;
+                std::lock_guard<std::mutex> g(m);
+                if (e.lastWrite > newestTime) {
+                    newestTime = e.lastWrite;
+                    newest = name;
+                }
+                return WalkAction::Continue;
+            });
+        }
+    }
+    return newest;
+}
+
+// Only player versions are pruned: a folder must hold RobloxPlayerBeta.exe and
+// no RobloxStudioBeta.exe. While an installer started by this run may still be
+// unpacking, the newest folder is not a reliable guide, so nothing is pruned.
+static void PruneRobloxVersions(HWND log, const std::wstring& expected, bool installerStarted) {
+    AppendLog(log, L"Pruning stale Roblox versions...");
+    if (installerStarted) {
+        AppendLog(log, L" The Roblox installer ran during this fix; keeping all versions until the next run.");
+        return;
+    }
+    IFileSystem& fs = DefaultFileSystem();
+    std::vector<std::filesystem::path> roots = { ActiveFixPaths().programFilesVersions };
+    std::wstring local = GetLocalAppData();
+    if (!local.empty()) roots.insert(roots.begin(), std::filesystem::path(local) / L"Roblox" / L"Versions");
+    std::wstring active = ActiveRobloxVersion(fs, roots, expected);
+    if (active.empty()) {
+        AppendLog(log, L" Could not determine the live Roblox version; keeping all versions.");
+        return;
+    }
+    BackgroundDeleter& background = DefaultBackgroundDeleter();
+    size_t pruned = 0;
+    unsigned long long reclaimed = 0;
+    for (const auto& root : roots) {
+        background.SweepLeftovers(root);
+        for (const auto& name : fs.List(root)) {
+            if (!IsVersionDirName(name) || CaseInsensitiveEquals(name, active) || !fs.IsDirectory(root / name)) continue;
+            if (fs.Exists(root / name / L"RobloxStudioBeta.exe") || !fs.Exists(root / name / L"RobloxPlayerBeta.exe")) {
+                AppendLog(log, L" Keeping " + name + L"; it is not a Roblox Player version.");
+                continue;
+            }
+            std::mutex m;
+            std::vector<WalkEntry> files;
+            WalkOptions opts;
+            opts.skipCloudPlaceholders = false;
+            fs.Walk({ (root / name).wstring() }, opts, [&](const WalkEntry& e) {
+                if (e.IsDirectory()) return WalkAction::Continue;
+                std::lock_guard<std::mutex> g(m);
+                files.push_back(e);
+                return WalkAction::Continue;
+            });
+            std::atomic<unsigned long long> unique{0};
+            ParallelFor(files.size(), 0, [&](size_t i) {
+                if (fs.LinkCount(files[i].path) <= 1) unique += files[i].size;
+            });
+            if (!background.Tombstone(root / name, name)) {
+                AppendLog(log, L" Could not remove " + (root / name).wstring() + L"; it may be in use.");
+                continue;
+            }
+            AppendLog(log, L" Removing " + name + L" (" + FormatBytes(unique) + L" not shared with " + active + L").");
+            ++pruned;
+            reclaimed += unique;
+        }
+    }
+    if (pruned == 0) {
+        AppendLog(log, L" No stale player versions besides " + active + L"; nothing to prune.");
+        return;
+    }
+    AppendLog(log, L" Keeping " + active + L"; pruned " + std::to_wstring(pruned) + L" stale versions, reclaiming " +
+                   FormatBytes(reclaimed) + L".");
+}
+
+static void MoveRobloxVersionsToLocalAppData(HWND log, const std::wstring& expected) {
+    IFileSystem& fs = DefaultFileSystem();
+    std::filesystem::path src = ActiveFixPaths().programFilesVersions;
+    std::filesystem::path journal = GetBackupRoot() / L"VersionsMove.journal";
+    std::error_code ec;
+    if (!fs.Exists(src) && !std::filesystem::exists(journal, ec)) {
+        AppendLog(log, L"Source Versions folder not found in Program Files (x86).");
+        return;
+    }
+    std::wstring local = GetLocalAppData();
+    if (local.empty()) {
+        AppendLog(log, L"Unable to resolve LocalAppData for move.");
+        return;
+    }
+    std::filesystem::path dstRoot = std::filesystem::path(local) / L"Roblox";
+    std::filesystem::path dst = dstRoot / L"Versions";
+    fs.CreateDirectories(dst);
+    std::wstring active = ActiveRobloxVersion(fs, { dst, src }, expected);
+    if (active.empty()) {
+        AppendLog(log, L"Could not determine the live Roblox version; leaving Program Files versions in place.");
+    } else if (fs.Exists(src / active)) {
+        AppendLog(log, L"Moving " + active + L" to LocalAppData\\Roblox\\Versions...");
+    }
+    VersionsMover mover(fs, src, dst, journal, active, log);
+    if (!mover.Run()) {
+        AppendLog(log, L"Move incomplete; remaining versions were left in place.");
+        return;
+    }
+    AppendLog(log, L"Move complete.");
+}
+
+struct AppState {
+    HWND hButton{};
+    HWND hLog{};
+    HWND hProgress{};
+    bool running{false};
+    std::thread worker;
+};
+
+struct FixStepContext {
+    std::function<void(int)> report;
+    void Report(int percent) const {
+        if (report) report(percent);
+    }
+};
+
+struct FixStep {
+    std::wstring id;
+    std::wstring title;
+    std::vector<std::wstring> dependsOn;
+    std::vector<std::wstring> conflictsWith;
+    int weight{1};
+    std::function<bool(FixStepContext&)> run;
+    bool rerunOnResume{false};
+};
+
+enum class FixStepState { Pending, Running, Succeeded, Failed };
+
+struct StepGraphObserver {
+    std::function<void(int)> progress;
+    std::function<void(const FixStep&, size_t, size_t)> started;
+    std::function<void(const FixStep&, bool, long long)> finished;
+};
+
+static bool StepsConflict(const FixStep& a, const FixStep& b) {
+    return std::find(a.conflictsWith.begin(), a.conflictsWith.end(), b.id) != a.conflictsWith.end() ||
+           std::find(b.conflictsWith.begin(), b.conflictsWith.end(), a.id) != b.conflictsWith.end();
+}
+
+static bool RunStepGraph(const StepGraphObserver& observer, HWND log, const std::vector<FixStep>& steps, size_t maxWorkers) {
+    std::map<std::wstring, size_t> index;
+    for (size_t i = 0; i < steps.size(); ++i) index[steps[i].id] = i;
+
+    std::vector<std::vector<size_t>> deps(steps.size());
+    for (size_t i = 0; i < steps.size(); ++i) {
+        for (const auto& d : steps[i].dependsOn) {
+            auto it = index.find(d);
+            if (it == index.end()) {
+                AppendLog(log, L" Step '" + steps[i].id + L"' depends on unknown step '" + d + L"'; ignoring.");
+                continue;
+            }
+            deps[i].push_back(it->second);
+        }
+    }
+
+    int totalWeight = 0;
+    for (const auto& st : steps) totalWeight += (std::max)(st.weight, 1);
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<FixStepState> state(steps.size(), FixStepState::Pending);
+    std::vector<int> partial(steps.size(), 0);
+    size_t finished = 0;
+    size_t running = 0;
+    int lastPosted = 0;
+    bool allOk = true;
+
+    auto postProgress = [&]() {
+        int done = 0;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            int w = (std::max)(steps[i].weight, 1);
+            if (state[i] == FixStepState::Succeeded || state[i] == FixStepState::Failed) done += w * 100;
+            else if (state[i] == FixStepState::Running) done += w * partial[i];
+        }
+        int pct = totalWeight ? done / totalWeight : 100;
+        if (pct > lastPosted) {
+            lastPosted = pct;
+            if (observer.progress) observer.progress(pct);
+        }
+    };
+
+    auto pickRunnable = [&]() -> size_t {
+        for (size_t i = 0; i < steps.size(); ++i) {
+            if (state[i] != FixStepState::Pending) continue;
+            bool ready = true;
+            for (size_t d : deps[i]) {
+                if (state[d] == FixStepState::Pending || state[d] == FixStepState::Running) { ready = false; break; }
+            }
+            if (!ready) continue;
+            for (size_t j = 0; j < steps.size() && ready; ++j) {
+                if (state[j] == FixStepState::Running && StepsConflict(steps[i], steps[j])) ready = false;
+            }
+            if (ready) return i;
+        }
+        return steps.size();
+    };
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lk(m);
+        for (;;) {
+            size_t next = steps.size();
+            cv.wait(lk, [&]() {
+                if (finished == steps.size()) return true;
+                next = pickRunnable();
+                if (next != steps.size()) return true;
+                return running == 0;
+            });
+            if (finished == steps.size()) return;
+            if (next == steps.size()) {
+                for (size_t i = 0; i < steps.size(); ++i) {
+                    if (state[i] != FixStepState::Pending) continue;
+                    state[i] = FixStepState::Failed;
+                    ++finished;
+                    allOk = false;
+                    AppendLog(log, L" Step '" + steps[i].id + L"' could not be scheduled (dependency cycle).");
+                }
+                cv.notify_all();
+                return;
+            }
+
+            if (g_cancelRequested.load()) {
+                state[next] = FixStepState::Failed;
+                ++finished;
+                allOk = false;
+                AppendLog(log, L" Skipping '" + steps[next].id + L"': run cancelled.");
+                cv.notify_all();
+                continue;
+            }
+            state[next] = FixStepState::Running;
+            ++running;
+            size_t started = finished + running;
+            lk.unlock();
+
+            const FixStep& step = steps[next];
+            AppendLog(log, L"[" + std::to_wstring(started) + L"/" + std::to_wstring(steps.size()) + L"] " + step.title);
+            if (observer.started) observer.started(step, started, steps.size());
+            auto stepStart = std::chrono::steady_clock::now();
+            FixStepContext ctx;
+            ctx.report = [&, next](int percent) {
+                std::lock_guard<std::mutex> g(m);
+                partial[next] = (std::min)((std::max)(percent, 0), 100);
+                postProgress();
+            };
+            bool ok = false;
+            TraceScope trace(L"step", step.id.c_str());
+            try {
+                ok = step.run ? step.run(ctx) : true;
+            } catch (...) {
+                AppendLog(log, L" Step '" + step.id + L"' threw an unexpected exception.");
+                ok = false;
+            }
+            trace.Result(ok ? 1 : 0);
+            AppendLog(log, L" " + step.title + (ok ? L" done." : L" failed."));
+            if (observer.finished) {
+                observer.finished(step, ok, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                std::chrono::steady_clock::now() - stepStart).count());
+            }
+
+            lk.lock();
+            state[next] = ok ? FixStepState::Succeeded : FixStepState::Failed;
+            if (!ok) allOk = false;
+            --running;
+            ++finished;
+            postProgress();
+            cv.notify_all();
+        }
+    };
+
+    size_t workers = (std::max)((size_t)1, (std::min)(maxWorkers, steps.size()));
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < workers; ++i) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    return allOk;
+}
+
+static size_t DefaultStepWorkers() {
+    unsigned hc = std::thread::hardware_concurrency();
+    return (std::min)((size_t)4, (size_t)(std::max)(hc, 2u));
+}
+
+static std::vector<std::wstring> SplitList(const std::wstring& s, wchar_t sep) {
+    std::vector<std::wstring> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(sep, start);
+        if (end == std::wstring::npos) end = s.size();
+        std::wstring item = Trim(s.substr(start, end - start));
+        if (!item.empty()) out.push_back(item);
+        start = end + 1;
+    }
+    return out;
+}
+
+struct RunJournalState {
+    bool incomplete{false};
+    bool changeDns{false};
+    std::vector<std::wstring> selection;
+    std::set<std::wstring> finished;
+    std::map<std::wstring, std::wstring> values;
+    std::wstring lastStarted;
+};
+
+class RunJournal {
+public:
+    explicit RunJournal(std::filesystem::path file) : file_(std::move(file)) {}
+
+    RunJournalState Load() const {
+        RunJournalState state;
+        bool sawRun = false;
+        for (const auto& r : ReadJournal(file_)) {
+            if (r.first == L"run") {
+                state = RunJournalState();
+                sawRun = true;
+                state.incomplete = true;
+                state.changeDns = r.second == L"dns=1";
+            } else if (r.first == L"select") {
+                state.selection = SplitList(r.second, L',');
+            } else if (r.first == L"start") {
+                state.lastStarted = r.second;
+            } else if (r.first == L"ok") {
+                state.finished.insert(r.second);
+            } else if (r.first == L"set") {
+                size_t eq = r.second.find(L'=');
+                if (eq != std::wstring::npos) state.values[r.second.substr(0, eq)] = r.second.substr(eq + 1);
+            } else if (r.first == L"end") {
+                state.incomplete = false;
+            }
+        }
+        if (!sawRun) state.incomplete = false;
+        return state;
+    }
+
+    void Begin(bool changeDns, const std::vector<std::wstring>& selection) {
+        std::lock_guard<std::mutex> g(m_);
+        std::error_code ec;
+        std::filesystem::remove(file_, ec);
+        AppendDurableLine(file_, std::wstring(L"run ") + (changeDns ? L"dns=1" : L"dns=0"));
+        if (!selection.empty()) {
+            std::wstring list;
+            for (const auto& id : selection) list += (list.empty() ? L"" : L",") + id;
+            AppendDurableLine(file_, L"select " + list);
+        }
+    }
+
+    void Resume() {
+        std::lock_guard<std::mutex> g(m_);
+        AppendDurableLine(file_, L"resume " + std::to_wstring(GetCurrentProcessId()));
+    }
+
+    void StepStarted(const std::wstring& id) {
+        std::lock_guard<std::mutex> g(m_);
+        AppendDurableLine(file_, L"start " + id);
+    }
+
+    void Set(const std::wstring& key, const std::wstring& value) {
+        std::lock_guard<std::mutex> g(m_);
+        AppendDurableLine(file_, L"set " + key + L"=" + value);
+    }
+
+    void StepFinished(const std::wstring& id, bool ok) {
+        std::lock_guard<std::mutex> g(m_);
+        AppendDurableLine(file_, (ok ? L"ok " : L"fail ") + id);
+    }
+
+    void End(bool ok) {
+        std::lock_guard<std::mutex> g(m_);
+        AppendDurableLine(file_, ok ? L"end ok" : L"end fail");
+    }
+
+private:
+    std::filesystem::path file_;
+    std::mutex m_;
+};
+
+static RunJournal& DefaultRunJournal() {
+    static RunJournal journal(GetBackupRoot() / L"Run.journal");
+    return journal;
+}
+
+struct FixRunState {
+    std::filesystem::path vcRedist;
+    std::filesystem::path robloxInstaller;
+    bool vcDownloaded{false};
+    bool robloxDownloaded{false};
+    bool robloxStarted{false};
+    bool robloxCurrent{false};
+    std::wstring robloxVersion;
+    bool vcHealthy{false};
+    bool componentStoreRepaired{false};
+};
+
+// The version check decides whether backup, delete and restore touch the
+// user's Roblox data, so its result is journaled rather than recomputed on
+// resume: after a partial run the install on disk no longer reflects it.
+static void JournalRobloxCheck(const FixRunState& run) {
+    DefaultRunJournal().Set(L"roblox-current", run.robloxCurrent ? L"1" : L"0");
+    DefaultRunJournal().Set(L"roblox-version", run.robloxVersion);
+}
+
+static void RestoreRunState(FixRunState& run, const RunJournalState& previous) {
+    auto current = previous.values.find(L"roblox-current");
+    if (current != previous.values.end()) run.robloxCurrent = current->second == L"1";
+    auto version = previous.values.find(L"roblox-version");
+    if (version != previous.values.end()) run.robloxVersion = version->second;
+    auto started = previous.values.find(L"roblox-started");
+    if (started != previous.values.end()) run.robloxStarted = started->second == L"1";
+}
+
+static std::vector<FixStep> BuildFixSteps(HWND log, const std::shared_ptr<FixRunState>& run, bool changeDns) {
+    std::vector<FixStep> steps;
+    steps.push_back({L"dism", L"Running DISM...", {}, {}, 6,
+        [log, run](FixStepContext& ctx) { return Cleanup(log, ctx.report, run->componentStoreRepaired); }});
+    steps.push_back({L"time", L"Syncing date and time...", {}, {}, 1,
+        [log](FixStepContext&) { return Synctime(log); }});
+    steps.push_back({L"sfc", L"Starting SFC...", {L"dism"}, {}, 6,
+        [log, run](FixStepContext& ctx) { return RunSFC(log, ctx.report, run->componentStoreRepaired); }});
+    steps.push_back({L"vcredist-download", L"Downloading VC++ redistributable...", {}, {}, 1,
+        [log, run](FixStepContext& ctx) {
+            if ((run->vcHealthy = RuntimeHealthy(log, L"vcruntime", L"VC++ runtime", ProbeVcRuntime))) return true;
+            return run->vcDownloaded = DownloadVCRedist(log, run->vcRedist, ctx.report);
+        }, true});
+    steps.push_back({L"vcredist", L"Installing/repairing VC++ redistributable...", {L"vcredist-download"}, {L"dism", L"sfc"}, 2,
+        [log, run](FixStepContext&) { return run->vcHealthy || (run->vcDownloaded && InstallOrRepairVCRedist(log, run->vcRedist)); }});
+    steps.push_back({L"webview", L"Repairing webview2...", {}, {}, 1,
+        [log](FixStepContext&) { return RepairWebView2Data(log); }});
+    if (changeDns) {
+        steps.push_back({L"dns", L"Setting DNS to 1.1.1.1...", {}, {}, 1,
+            [log](FixStepContext&) { return SetDnsToCloudflare(log); }});
+    }
+    steps.push_back({L"dep", L"Enabling DEP...", {}, {}, 1,
+        [log](FixStepContext&) { return EnableDEP(log); }});
+    steps.push_back({L"defender", L"Adding Defender exclusions for zenith...", {}, {}, 2,
+        [log](FixStepContext&) { AddZenithDefenderExclusions(log); return true; }});
+    steps.push_back({L"version", L"Checking installed Roblox version...", {}, {}, 1,
+        [log, run](FixStepContext&) {
+            run->robloxCurrent = RobloxIsCurrent(log, run->robloxVersion);
+            JournalRobloxCheck(*run);
+            return true;
+        }});
+    steps.push_back({L"backup", L"Backing up Roblox data...", {L"version"}, {}, 2,
+        [log, run](FixStepContext&) { if (!run->robloxCurrent) BackupRobloxData(log); return true; }});
+    steps.push_back({L"delete", L"Deleting LocalAppData Roblox/fishstrap/bloxstrap...", {L"backup"}, {}, 2,
+        [log, run](FixStepContext&) { DeleteAppDataDirs(log, run->robloxCurrent); return true; }});
+    steps.push_back({L"roblox-download", L"Downloading Roblox installer...", {L"version"}, {}, 2,
+        [log, run](FixStepContext& ctx) {
+            if (run->robloxCurrent) return true;
+            return run->robloxDownloaded = DownloadRobloxInstaller(log, run->robloxInstaller, ctx.report);
+        }, true});
+    steps.push_back({L"install", L"Attempting per-user Roblox install...", {L"delete", L"roblox-download"}, {}, 1,
+        [log, run](FixStepContext&) {
+            if (run->robloxCurrent) return true;
+            run->robloxStarted = run->robloxDownloaded && InstallRobloxToLocalAppData(log, run->robloxInstaller);
+            DefaultRunJournal().Set(L"roblox-started", run->robloxStarted ? L"1" : L"0");
+            return run->robloxStarted;
+        }});
+    steps.push_back({L"move", L"Moving Versions to LocalAppData...", {L"install"}, {}, 2,
+        [log, run](FixStepContext&) { MoveRobloxVersionsToLocalAppData(log, run->robloxVersion); return true; }});
+    steps.push_back({L"kill", L"Closing Roblox processes before restore...", {L"move"}, {}, 1,
+        [log](FixStepContext&) { KillRobloxProcesses(log); return true; }});
+    steps.push_back({L"restore", L"Restoring Roblox data...", {L"kill"}, {}, 2,
+        [log, run](FixStepContext&) { if (!run->robloxCurrent) RestoreRobloxData(log); return true; }});
+    steps.push_back({L"prune", L"Pruning stale Roblox versions...", {L"kill"}, {}, 1,
+        [log, run](FixStepContext&) { PruneRobloxVersions(log, run->robloxVersion, run->robloxStarted); return true; }});
+    return steps;
+}
+
+static bool SelectSteps(std::vector<FixStep>& steps, const std::vector<std::wstring>& ids, std::wstring& error) {
+    if (ids.empty()) return true;
+    std::set<std::wstring> wanted(ids.begin(), ids.end());
+    for (const auto& id : wanted) {
+        bool known = std::any_of(steps.begin(), steps.end(), [&](const FixStep& st) { return st.id == id; });
+        if (!known) {
+            error = L"Unknown or disabled step: " + id;
+            return false;
+        }
+    }
+    std::vector<FixStep> kept;
+    for (auto& st : steps) {
+        if (!wanted.count(st.id)) continue;
+        st.dependsOn.erase(std::remove_if(st.dependsOn.begin(), st.dependsOn.end(),
+                                          [&](const std::wstring& d) { return !wanted.count(d); }),
+                           st.dependsOn.end());
+        kept.push_back(std::move(st));
+    }
+    steps.swap(kept);
+    return true;
+}
+
+// Finished steps are skipped, except rerunOnResume steps that some pending step
+// reaches through its dependencies, directly or via finished steps in between:
+// their in-memory results are gone and downstream steps still read them.
+// Dependencies on skipped steps are replaced by what those steps depended on,
+// so a re-run step still finishes before everything downstream of it.
+static size_t SkipFinishedSteps(std::vector<FixStep>& steps, const std::set<std::wstring>& finished) {
+    std::map<std::wstring, const FixStep*> byId;
+    for (const auto& st : steps) byId[st.id] = &st;
+    std::set<std::wstring> pending;
+    for (const auto& st : steps) {
+        if (!finished.count(st.id)) pending.insert(st.id);
+    }
+    std::vector<std::wstring> stack(pending.begin(), pending.end());
+    std::set<std::wstring> visited(pending.begin(), pending.end());
+    while (!stack.empty()) {
+        auto it = byId.find(stack.back());
+        stack.pop_back();
+        if (it == byId.end()) continue;
+        for (const auto& dep : it->second->dependsOn) {
+            if (!visited.insert(dep).second) continue;
+            stack.push_back(dep);
+            auto d = byId.find(dep);
+            if (d != byId.end() && d->second->rerunOnResume) pending.insert(dep);
+        }
+    }
+
+    std::map<std::wstring, std::vector<std::wstring>> deps;
+    for (const auto& id : pending) {
+        std::set<std::wstring> seen;
+        std::vector<std::wstring> walk(byId[id]->dependsOn);
+        while (!walk.empty()) {
+            std::wstring dep = walk.back();
+            walk.pop_back();
+            if (!seen.insert(dep).second) continue;
+            if (pending.count(dep)) {
+                deps[id].push_back(dep);
+                continue;
+            }
+            auto d = byId.find(dep);
+            if (d != byId.end()) walk.insert(walk.end(), d->second->dependsOn.begin(), d->second->dependsOn.end());
+        }
+    }
+
+    size_t skipped = steps.size() - pending.size();
+    std::vector<FixStep> kept;
+    for (auto& st : steps) {
+        if (!pending.count(st.id)) continue;
+        st.dependsOn = deps[st.id];
+        kept.push_back(std::move(st));
+    }
+    steps.swap(kept);
+    return skipped;
+}
+
+static StepGraphObserver WithJournal(StepGraphObserver observer, RunJournal& journal) {
+    auto started = observer.started;
+    auto finished = observer.finished;
+    observer.started = [started, &journal](const FixStep& st, size_t index, size_t total) {
+        journal.StepStarted(st.id);
+        if (started) started(st, index, total);
+    };
+    observer.finished = [finished, &journal](const FixStep& st, bool ok, long long ms) {
+        journal.StepFinished(st.id, ok);
+        if (finished) finished(st, ok, ms);
+    };
+    return observer;
+}
+
+static void DoFixWorkflow(HWND hwnd, AppState* state) {
+    if (!IsProcessElevated()) {
+        int r = MessageBoxW(hwnd,
+            L"This will make system-level changes.\n\nAdministrator rights are required. Continue?",
+            L"Elevation required", MB_ICONWARNING | MB_OKCANCEL);
+        if (r != IDOK) return;
+        if (RelaunchElevated(hwnd)) {
+            PostQuitMessage(0);
+            return;
+        } else {
+            MessageBoxW(hwnd, L"Failed to relaunch elevated.", L"Error", MB_ICONERROR);
+            return;
+        }
+    }
+    RunJournalState previous = DefaultRunJournal().Load();
+    bool resume = false;
+    if (previous.incomplete) {
+        int choice = MessageBoxW(hwnd,
+            (L"The previous fix run did not finish (" + std::to_wstring(previous.finished.size()) +
+             L" steps completed).\n\nResume where it left off? Choose No to start over.").c_str(),
+            L"Resume previous run?", MB_ICONQUESTION | MB_YESNOCANCEL);
+        if (choice == IDCANCEL) return;
+        resume = choice == IDYES;
+    }
+    bool changeDns = previous.changeDns;
+    if (!resume) {
+        int confirm = MessageBoxW(hwnd,
+            L"This will:\n"
+            L" - Add Windows Defender exclusions for 'zenith' folders in Downloads (folders only)\n"
+            L" - Delete LocalAppData folders: Roblox, fishstrap, bloxstrap\n\nProceed?",
+            L"Confirm actions", MB_ICONWARNING | MB_OKCANCEL);
+        if (confirm != IDOK) return;
+        int dnsChoice = MessageBoxW(hwnd,
+            L"Changing your DNS to 1.1.1.1.\n\nIf you are on a school or work computer/laptop please decline this DNS change as it may get you in trouble from your school or work company.",
+            L"Change DNS to 1.1.1.1?", MB_ICONWARNING | MB_YESNO);
+        changeDns = dnsChoice == IDYES;
+    }
+    state->running = true;
+    EnableWindow(state->hButton, FALSE);
+
+    PostMessageW(hwnd, WM_APP_PROGRESS, (WPARAM)0, 0);
+
+    state->worker = std::thread([hwnd, state, changeDns, resume, previous]() {
+        HWND log = state->hLog;
+        if (changeDns) {
+            AppendLog(log, L"User accepted DNS change.");
+        } else {
+            AppendLog(log, L"User declined DNS change. Skipping DNS modification.");
+        }
+
+        auto run = std::make_shared<FixRunState>();
+        std::vector<FixStep> steps = BuildFixSteps(log, run, changeDns);
+        RunJournal& journal = DefaultRunJournal();
+        if (resume) {
+            std::wstring error;
+            SelectSteps(steps, previous.selection, error);
+            RestoreRunState(*run, previous);
+            size_t skipped = SkipFinishedSteps(steps, previous.finished);
+            journal.Resume();
+            AppendLog(log, L"Resuming previous run; skipping " + std::to_wstring(skipped) + L" finished steps.");
+        } else {
+            journal.Begin(changeDns, {});
+        }
+        {
+            TraceScope trace(L"run", L"fix");
+            StepGraphObserver observer;
+            observer.progress = [hwnd](int pct) { PostMessageW(hwnd, WM_APP_PROGRESS, (WPARAM)pct, 0); };
+            bool ok = RunStepGraph(WithJournal(observer, journal), log, steps, DefaultStepWorkers());
+            for (const auto& r : DefaultBackgroundDeleter().Wait()) LogDeleteReport(log, r);
+            if (!g_cancelRequested.load()) journal.End(ok);
+        }
+        AppendLog(log, DefaultArtifactCache().StatsLine());
+        WriteTraceReport(log);
+
+        if (!run->robloxStarted && !run->robloxCurrent) {
+            AppendLog(log, L"Roblox installer not started automatically. You can run it manually from LocalAppData\\Temp.");
+        }
+
+        PostLogAndProgress(hwnd, log, L"All steps complete. Please restart your PC.", 100);
+        PostMessageW(hwnd, WM_APP_FIX_DONE, 0, 0);
+    });
+}
+
+static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    static AppState* state = nullptr;
+    switch (msg) {
+        case WM_CREATE: {
+            state = new AppState();
+            HFONT hFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+
+            state->hButton = CreateWindowW(L"BUTTON", L"Fix",
+                                           WS_CHILD | WS_VISIBLE | BS_DEFPUSHBUTTON,
+                                           20, 20, 100, 32, hwnd, (HMENU)1001, GetModuleHandleW(nullptr), nullptr);
+
+            state->hLog = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"",
+                                          WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_OWNERDATA | LVS_NOCOLUMNHEADER | LVS_SINGLESEL,
+                                          20, 110, 560, 280, hwnd, (HMENU)1002, GetModuleHandleW(nullptr), nullptr);
+            LVCOLUMNW col{};
+            col.mask = LVCF_WIDTH;
+            col.cx = 536;
+            SendMessageW(state->hLog, LVM_INSERTCOLUMNW, 0, (LPARAM)&col);
+            SendMessageW(state->hLog, LVM_SETEXTENDEDLISTVIEWSTYLE, LVS_EX_DOUBLEBUFFER, LVS_EX_DOUBLEBUFFER);
+
+            state->hProgress = CreateWindowExW(
+    0,
+    PROGRESS_CLASSW,
+    nullptr,
+    WS_CHILD | WS_VISIBLE,
+    20, 60, 560, 20,
+    hwnd,
+    (HMENU)1003,
+    GetModuleHandleW(nullptr),
+    nullptr
+);
+
+            SendMessageW(state->hButton, WM_SETFONT, (WPARAM)hFont, TRUE);
+            SendMessageW(state->hLog, WM_SETFONT, (WPARAM)hFont, TRUE);
+
+            SendMessageW(state->hProgress, PBM_SETRANGE32, 0, 100);
+            SendMessageW(state->hProgress, PBM_SETPOS, 0, 0);
+
+            Logs().Attach(state->hLog, state->hProgress, GetBackupRoot() / L"logs");
+            SetTimer(hwnd, kLogTimerId, 50, nullptr);
+            AppendLog(state->hLog, L"Ready. Click Fix to start.");
+            if (DefaultRunJournal().Load().incomplete) {
+                AppendLog(state->hLog, L"A previous run was interrupted. Click Fix to resume it.");
+            }
+            break;
+        }
+        case WM_TIMER: {
+            if (wParam == kLogTimerId) Logs().Pump();
+            break;
+        }
+        case WM_NOTIFY: {
+            auto* hdr = (NMHDR*)lParam;
+            if (state && hdr->hwndFrom == state->hLog && hdr->code == LVN_GETDISPINFOW) {
+                auto* di = (NMLVDISPINFOW*)lParam;
+                if (di->item.mask & LVIF_TEXT) {
+                    wcsncpy(di->item.pszText, Logs().Line(di->item.iItem), di->item.cchTextMax - 1);
+                    di->item.pszText[di->item.cchTextMax - 1] = L'\0';
+                }
+                break;
+            }
+            return DefWindowProcW(hwnd, msg, wParam, lParam);
+        }
+        case WM_COMMAND: {
+            if (LOWORD(wParam) == 1001) {
+                if (state && !state->running) {
+                    DoFixWorkflow(hwnd, state);
+                }
+            }
+            break;
+        }
+        case WM_APP_PROGRESS: {
+            int p = (int)wParam;
+            SendMessageW(state->hProgress, PBM_SETPOS, p, 0);
+            break;
+        }
+        case WM_APP_FIX_DONE: {
+            if (state->worker.joinable()) state->worker.join();
+            EnableWindow(state->hButton, TRUE);
+            state->running = false;
+            MessageBoxW(hwnd, L"Fix completed.\n\nPlease restart your PC.", L"Done", MB_ICONINFORMATION);
+            break;
+        }
+        case WM_DESTROY: {
+            g_cancelRequested = true;
+            KillTimer(hwnd, kLogTimerId);
+            if (state->worker.joinable()) state->worker.join();
+            Logs().Shutdown();
+            delete state;
+            PostQuitMessage(0);
+            break;
+        }
+        default:
+            return DefWindowProcW(hwnd, msg, wParam, lParam);
+    }
+    return 0;
+}
+
+struct CliOptions {
+    std::vector<std::wstring> steps;
+    bool changeDns{false};
+    bool yes{false};
+    bool dryRun{false};
+    bool listSteps{false};
+    bool resume{false};
+    bool help{false};
+    bool bench{false};
+    std::wstring benchFilter;
+    int benchScale{1};
+    size_t benchIterations{5};
+    bool selfTest{false};
+    std::wstring selfTestFilter;
+};
+
+static bool IsCliInvocation(int argc, wchar_t** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (wcsncmp(argv[i], L"--", 2) == 0) return true;
+    }
+    return false;
+}
+
+static bool ParseCliOptions(int argc, wchar_t** argv, CliOptions& opts, std::wstring& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::wstring arg = argv[i];
+        if (arg.rfind(L"--steps=", 0) == 0) {
+            opts.steps = SplitList(arg.substr(8), L',');
+        } else if (arg == L"--dns=yes") {
+            opts.changeDns = true;
+        } else if (arg == L"--dns=no") {
+            opts.changeDns = false;
+        } else if (arg == L"--yes") {
+            opts.yes = true;
+        } else if (arg == L"--dry-run") {
+            opts.dryRun = true;
+        } else if (arg == L"--resume") {
+            opts.resume = true;
+        } else if (arg == L"--list-steps") {
+            opts.listSteps = true;
+        } else if (arg == L"--bench") {
+            opts.bench = true;
+        } else if (arg.rfind(L"--bench=", 0) == 0) {
+            opts.bench = true;
+            opts.benchFilter = arg.substr(8);
+        } else if (arg.rfind(L"--bench-scale=", 0) == 0) {
+            opts.benchScale = (int)wcstol(arg.c_str() + 14, nullptr, 10);
+            if (opts.benchScale < 1 || opts.benchScale > 100) {
+                error = L"--bench-scale must be between 1 and 100";
+                return false;
+            }
+        } else if (arg.rfind(L"--bench-iterations=", 0) == 0) {
+            int n = (int)wcstol(arg.c_str() + 19, nullptr, 10);
+            if (n < 1) {
+                error = L"--bench-iterations must be at least 1";
+                return false;
+            }
+            opts.benchIterations = (size_t)n;
+        } else if (arg == L"--selftest") {
+            opts.selfTest = true;
+        } else if (arg.rfind(L"--selftest=", 0) == 0) {
+            opts.selfTest = true;
+            opts.selfTestFilter = arg.substr(11);
+        } else if (arg == L"--help" || arg == L"-h" || arg == L"/?") {
+            opts.help = true;
+        } else {
+            error = L"Unknown argument: " + arg;
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<size_t> PlanStepOrder(const std::vector<FixStep>& steps) {
+    std::vector<size_t> order;
+    std::vector<bool> placed(steps.size(), false);
+    while (order.size() < steps.size()) {
+        bool progressed = false;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            if (placed[i]) continue;
+            bool ready = std::all_of(steps[i].dependsOn.begin(), steps[i].dependsOn.end(), [&](const std::wstring& d) {
+                for (size_t j = 0; j < steps.size(); ++j) {
+                    if (steps[j].id == d) return (bool)placed[j];
+                }
+                return true;
+            });
+            if (!ready) continue;
+            placed[i] = true;
+            order.push_back(i);
+            progressed = true;
+        }
+        if (!progressed) break;
+    }
+    return order;
+}
+
+class JsonLineWriter {
+public:
+    explicit JsonLineWriter(HANDLE out) : out_(out) {}
+
+    void Write(const std::string& line) {
+        if (!out_) return;
+        std::string buf = line + "\n";
+        std::lock_guard<std::mutex> g(m_);
+        DWORD written = 0;
+        WriteFile(out_, buf.data(), (DWORD)buf.size(), &written, nullptr);
+    }
+
+private:
+    HANDLE out_;
+    std::mutex m_;
+};
+
+static HANDLE OpenCliStdout() {
+    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (h && h != INVALID_HANDLE_VALUE) return h;
+    if (!AttachConsole(ATTACH_PARENT_PROCESS)) AllocConsole();
+    h = CreateFileW(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    return h == INVALID_HANDLE_VALUE ? nullptr : h;
+}
+
+struct BenchCase {
+    std::string name;
+    size_t iterations{0};
+    std::vector<double> ms;
+    unsigned long long items{0};
+    unsigned long long bytes{0};
+    unsigned long long matches{0};
+};
+
+class BenchTree {
+public:
+    BenchTree(IFileSystem& fs, std::filesystem::path root, int scale) : fs_(fs), root_(std::move(root)), scale_(scale) {
+        pool_.resize(256 * 1024);
+        for (auto& c : pool_) c = (char)(Next() & 0xFF);
+    }
+
+    const std::filesystem::path& Root() const { return root_; }
+    std::filesystem::path Versions() const { return root_ / L"Versions"; }
+    std::filesystem::path Storage() const { return root_ / L"rbx-storage"; }
+    std::filesystem::path Downloads() const { return root_ / L"Downloads"; }
+
+    unsigned long long Generate() {
+        unsigned long long bytes = 0;
+        static const wchar_t* kVersionDirs[] = { L"content\\fonts", L"content\\textures\\ui", L"content\\sky",
+                                                 L"PlatformContent\\pc\\textures", L"ExtraContent\\LuaPackages", L"shaders" };
+        for (int v = 0; v < 2; ++v) {
+            std::filesystem::path dir = Versions() / (L"version-" + Hex(Next(), 16));
+            for (const wchar_t* bin : { L"RobloxPlayerBeta.exe", L"RobloxPlayerBeta.dll", L"libGLESv2.dll" }) {
+                bytes += Write(dir / bin, 4 * 1024 * 1024);
+            }
+            for (int i = 0; i < 300 * scale_; ++i) {
+                bytes += Write(dir / kVersionDirs[i % 6] / (L"asset" + std::to_wstring(i) + L".rbxm"), 1024 + Next() % (48 * 1024));
+            }
+        }
+        for (int i = 0; i < 1500 * scale_; ++i) {
+            std::wstring h = Hex(Next(), 32);
+            bytes += Write(Storage() / h.substr(0, 2) / h, 512 + Next() % (16 * 1024));
+        }
+        static const wchar_t* kClutter[] = { L"IMG_", L"Screenshot ", L"invoice-", L"setup_", L"Document (", L"song " };
+        static const wchar_t* kExt[] = { L".jpg", L".png", L".pdf", L".zip", L".exe", L".crdownload", L".mp3", L".docx" };
+        for (int i = 0; i < 4000 * scale_; ++i) {
+            std::wstring name = std::wstring(kClutter[i % 6]) + std::to_wstring(i) + kExt[Next() % 8];
+            std::filesystem::path p = (i % 5 == 0) ? Downloads() / (L"Folder " + std::to_wstring(i % 40)) / name : Downloads() / name;
+            bytes += Write(p, 64 + Next() % 2048);
+        }
+        for (int i = 0; i < 8; ++i) {
+            std::wstring name = i ? L"RobloxPlayerInstaller (" + std::to_wstring(i) + L").exe" : L"RobloxPlayerInstaller.exe";
+            bytes += Write(Downloads() / name, 1024 * 1024);
+        }
+        return bytes;
+    }
+
+    std::vector<std::wstring> DownloadNames() {
+        std::vector<std::wstring> names;
+        std::mutex m;
+        WalkOptions opts;
+        opts.skipCloudPlaceholders = false;
+        fs_.Walk({ Downloads().wstring() }, opts, [&](const WalkEntry& e) {
+            std::lock_guard<std::mutex> g(m);
+            names.push_back(e.name);
+            return WalkAction::Continue;
+        });
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+private:
+    unsigned long long Next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    static std::wstring Hex(unsigned long long v, size_t digits) {
+        static const wchar_t* kDigits = L"0123456789abcdef";
+        std::wstring s;
+        while (s.size() < digits) {
+            s.push_back(kDigits[v & 15]);
+            v = (v >> 4) | (v << 60);
+            if (s.size() % 16 == 0) v = v * 0x9E3779B97F4A7C15ull + 1;
+        }
+        return s;
+    }
+
+    unsigned long long Write(const std::filesystem::path& p, size_t size) {
+        fs_.CreateDirectories(p.parent_path());
+        std::string data;
+        data.reserve(size);
+        while (data.size() < size) {
+            size_t off = Next() % pool_.size();
+            data.append(pool_, off, (std::min)(size - data.size(), pool_.size() - off));
+        }
+        return fs_.WriteTextAtomic(p, data) ? size : 0;
+    }
+
+    IFileSystem& fs_;
+    std::filesystem::path root_;
+    int scale_;
+    std::string pool_;
+    unsigned long long state_{0x5A4E4954484649ull};
+};
+
+static BenchCase RunBenchCase(const std::string& name, size_t iterations, const std::function<void()>& setup,
+                              const std::function<void(BenchCase&)>& body) {
+    BenchCase bc;
+    bc.name = name;
+    bc.iterations = iterations;
+    for (size_t i = 0; i < iterations; ++i) {
+        if (setup) setup();
+        bc.items = 0;
+        bc.bytes = 0;
+        bc.matches = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        body(bc);
+        bc.ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return bc;
+}
+
+static std::string BenchCaseJson(const BenchCase& bc) {
+    std::vector<double> sorted = bc.ms;
+    std::sort(sorted.begin(), sorted.end());
+    double median = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    double mean = 0;
+    for (double v : sorted) mean += v;
+    if (!sorted.empty()) mean /= sorted.size();
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "{\"name\":\"%s\",\"iterations\":%zu,\"real_time\":%.3f,\"min_time\":%.3f,\"mean_time\":%.3f,\"time_unit\":\"ms\","
+             "\"items\":%llu,\"bytes\":%llu,\"matches\":%llu,\"items_per_second\":%.1f,\"bytes_per_second\":%.1f}",
+             bc.name.c_str(), bc.iterations, median, sorted.empty() ? 0 : sorted.front(), mean, bc.items, bc.bytes, bc.matches,
+             median > 0 ? bc.items * 1000.0 / median : 0, median > 0 ? bc.bytes * 1000.0 / median : 0);
+    return buf;
+}
+
+static int RunBenchmarks(JsonLineWriter& json, const std::wstring& filter, int scale, size_t iterations) {
+    IFileSystem& fs = DefaultFileSystem();
+    std::filesystem::path root = std::filesystem::path(GetLocalTemp()) / (L"ZenithFixerBench-" + std::to_wstring(GetCurrentProcessId()));
+    BenchTree tree(fs, root, scale);
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned long long generated = tree.Generate();
+    double setupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    char ctx[256];
+    snprintf(ctx, sizeof(ctx), "{\"event\":\"bench-context\",\"scale\":%d,\"threads\":%u,\"generated_bytes\":%llu,\"setup_ms\":%.1f}",
+             scale, std::thread::hardware_concurrency(), generated, setupMs);
+    json.Write(ctx);
+    std::vector<std::wstring> versions = fs.List(tree.Versions());
+    if (versions.empty()) {
+        fs.RemoveAll(root);
+        json.Write("{\"event\":\"error\",\"message\":\"Could not generate the benchmark tree under " + JsonEscape(root.wstring()) + "\"}");
+        return 1;
+    }
+
+    std::vector<std::wstring> names = tree.DownloadNames();
+    std::vector<std::wstring> installers;
+    for (int i = 0; i < 16; ++i) installers.push_back(L"robloxplayerinstaller (" + std::to_wstring(i) + L").EXE");
+    std::vector<std::wstring> patterns = { L"roblox", L"installer", L"bloxstrap", L"zenith" };
+    NameMatcher matcher(patterns);
+    std::filesystem::path version = tree.Versions() / versions.front();
+    std::filesystem::path scratch = root / L"scratch";
+    WalkOptions walkOpts;
+    walkOpts.skipCloudPlaceholders = false;
+    std::vector<std::filesystem::path> files;
+    std::mutex filesLock;
+    fs.Walk({ version.wstring() }, walkOpts, [&](const WalkEntry& e) {
+        std::lock_guard<std::mutex> g(filesLock);
+        if (!e.IsDirectory()) files.push_back(e.path);
+        return WalkAction::Continue;
+    });
+
+    std::vector<std::pair<std::string, std::function<BenchCase()>>> cases;
+    cases.push_back({ "scan/walk_all", [&] {
+        return RunBenchCase("scan/walk_all", iterations, nullptr, [&](BenchCase& bc) {
+            WalkStats s = fs.Walk({ tree.Versions().wstring(), tree.Storage().wstring(), tree.Downloads().wstring() }, walkOpts,
+                                  [](const WalkEntry&) { return WalkAction::Continue; });
+            bc.items = s.entries;
+        });
+    } });
+    cases.push_back({ "match/contains", [&] {
+        return RunBenchCase("match/contains", iterations, nullptr, [&](BenchCase& bc) {
+            for (const auto& n : names) {
+                for (const auto& p : patterns) bc.matches += ContainsCaseInsensitive(n, p);
+            }
+            bc.items = names.size();
+        });
+    } });
+    cases.push_back({ "match/name_matcher", [&] {
+        return RunBenchCase("match/name_matcher", iterations, nullptr, [&](BenchCase& bc) {
+            for (const auto& n : names) bc.matches += matcher.Match(n) != 0;
+            bc.items = names.size();
+        });
+    } });
+    cases.push_back({ "match/equals", [&] {
+        return RunBenchCase("match/equals", iterations, nullptr, [&](BenchCase& bc) {
+            for (const auto& n : names) {
+                for (const auto& i : installers) bc.matches += CaseInsensitiveEquals(n, i);
+            }
+            bc.items = names.size();
+        });
+    } });
+    std::unordered_set<std::wstring> snapshot;
+    cases.push_back({ "snapshot/build", [&] {
+        return RunBenchCase("snapshot/build", iterations, nullptr, [&](BenchCase& bc) {
+            snapshot = SnapshotDownloads(tree.Downloads().wstring());
+            bc.items = snapshot.size();
+        });
+    } });
+    cases.push_back({ "snapshot/contains", [&] {
+        if (snapshot.empty()) snapshot = SnapshotDownloads(tree.Downloads().wstring());
+        return RunBenchCase("snapshot/contains", iterations, nullptr, [&](BenchCase& bc) {
+            for (const auto& n : names) bc.matches += SnapshotContains(snapshot, n);
+            for (const auto& i : installers) bc.matches += SnapshotContains(snapshot, i);
+            bc.items = names.size() + installers.size();
+        });
+    } });
+    cases.push_back({ "hash/xxh64", [&] {
+        return RunBenchCase("hash/xxh64", iterations, nullptr, [&](BenchCase& bc) {
+            std::atomic<unsigned long long> bytes{0};
+            ParallelFor(files.size(), 0, [&](size_t i) {
+                Xxh64 h;
+                fs.ReadStream(files[i], [&](const char* data, size_t n) {
+                    h.Update(data, n);
+                    bytes += n;
+                });
+            });
+            bc.items = files.size();
+            bc.bytes = bytes;
+        });
+    } });
+    cases.push_back({ "hash/sha256", [&] {
+        return RunBenchCase("hash/sha256", iterations, nullptr, [&](BenchCase& bc) {
+            std::atomic<unsigned long long> bytes{0};
+            ParallelFor(files.size(), 0, [&](size_t i) {
+                Sha256 h;
+                fs.ReadStream(files[i], [&](const char* data, size_t n) {
+                    h.Update(data, n);
+                    bytes += n;
+                });
+            });
+            bc.items = files.size();
+            bc.bytes = bytes;
+        });
+    } });
+    cases.push_back({ "archive/backup", [&] {
+        return RunBenchCase("archive/backup", iterations, [&] { fs.RemoveAll(scratch / L"archive"); }, [&](BenchCase& bc) {
+            BackupArchive archive(fs, scratch / L"archive");
+            ArchiveReport r = archive.Backup(L"rbx-storage", tree.Storage());
+            bc.items = r.files;
+            bc.bytes = r.rawBytes;
+        });
+    } });
+    cases.push_back({ "archive/backup_unchanged", [&] {
+        BackupArchive(fs, scratch / L"archive").Backup(L"rbx-storage", tree.Storage());
+        return RunBenchCase("archive/backup_unchanged", iterations, nullptr, [&](BenchCase& bc) {
+            BackupArchive archive(fs, scratch / L"archive");
+            ArchiveReport r = archive.Backup(L"rbx-storage", tree.Storage());
+            bc.items = r.reused;
+            bc.bytes = r.readBytes;
+        });
+    } });
+    cases.push_back({ "archive/restore", [&] {
+        BackupArchive(fs, scratch / L"archive").Backup(L"rbx-storage", tree.Storage());
+        return RunBenchCase("archive/restore", iterations, [&] { fs.RemoveAll(scratch / L"unpacked"); }, [&](BenchCase& bc) {
+            BackupArchive archive(fs, scratch / L"archive");
+            ArchiveReport r = archive.Restore(L"rbx-storage", scratch / L"unpacked");
+            bc.items = r.files;
+            bc.bytes = r.rawBytes;
+        });
+    } });
+    cases.push_back({ "archive/extract_one", [&] {
+        BackupArchive(fs, scratch / L"archive").Backup(L"rbx-storage", tree.Storage());
+        std::vector<std::wstring> buckets = fs.List(tree.Storage());
+        std::vector<std::wstring> blobs = buckets.empty() ? std::vector<std::wstring>() : fs.List(tree.Storage() / buckets.back());
+        std::wstring rel = blobs.empty() ? std::wstring() : buckets.back() + L"\\" + blobs.back();
+        return RunBenchCase("archive/extract_one", iterations, nullptr, [&](BenchCase& bc) {
+            std::string data;
+            BackupArchive archive(fs, scratch / L"archive");
+            if (archive.Extract(L"rbx-storage", rel, data)) {
+                bc.items = 1;
+                bc.bytes = data.size();
+            }
+        });
+    } });
+    cases.push_back({ "copy/version_tree", [&] {
+        return RunBenchCase("copy/version_tree", iterations, [&] { fs.RemoveAll(scratch / L"copy"); }, [&](BenchCase& bc) {
+            BulkCopyReport r = fs.CopyTree(version, scratch / L"copy");
+            bc.items = r.files;
+            bc.bytes = r.bytes;
+            bc.matches = r.cloned;
+        });
+    } });
+    cases.push_back({ "copy/version_tree_std", [&] {
+        unsigned long long versionBytes = 0;
+        for (const auto& f : files) {
+            unsigned long long size = 0;
+            if (fs.FileSize(f, size)) versionBytes += size;
+        }
+        return RunBenchCase("copy/version_tree_std", iterations, [&] { fs.RemoveAll(scratch / L"copy"); }, [&](BenchCase& bc) {
+            std::error_code ec;
+            std::filesystem::copy(version, scratch / L"copy", std::filesystem::copy_options::recursive, ec);
+            bc.items = files.size();
+            bc.bytes = versionBytes;
+        });
+    } });
+    cases.push_back({ "delete/version_tree", [&] {
+        return RunBenchCase("delete/version_tree", iterations, [&] {
+            fs.RemoveAll(scratch / L"victim");
+            fs.CopyTree(version, scratch / L"victim");
+        }, [&](BenchCase& bc) {
+            DeleteReport r = DeleteTree(fs, scratch / L"victim", L"bench");
+            bc.items = r.files + r.directories;
+            bc.bytes = r.bytes;
+        });
+    } });
+    cases.push_back({ "powershell/host_round_trip", [&] {
+        DefaultPowerShellHost().Run(L"$null");
+        return RunBenchCase("powershell/host_round_trip", iterations, nullptr, [&](BenchCase& bc) {
+            for (int i = 0; i < 16; ++i) bc.matches += DefaultPowerShellHost().Run(L"Write-Output " + std::to_wstring(i)).exitCode == 0;
+            bc.items = 16;
+        });
+    } });
+    cases.push_back({ "powershell/host_batch", [&] {
+        DefaultPowerShellHost().Run(L"$null");
+        return RunBenchCase("powershell/host_batch", iterations, nullptr, [&](BenchCase& bc) {
+            std::vector<std::wstring> scripts;
+            for (int i = 0; i < 16; ++i) scripts.push_back(L"Write-Output " + std::to_wstring(i));
+            for (const auto& r : DefaultPowerShellHost().RunBatch(scripts)) bc.matches += r.exitCode == 0;
+            bc.items = scripts.size();
+        });
+    } });
+    cases.push_back({ "powershell/spawn_per_call", [&] {
+        return RunBenchCase("powershell/spawn_per_call", iterations, nullptr, [&](BenchCase& bc) {
+            for (int i = 0; i < 4; ++i) {
+                bc.matches += RunProcessWait(L"powershell.exe", L"-NoProfile -NonInteractive -EncodedCommand " +
+                                             EncodePowerShellScript(L"Write-Output " + std::to_wstring(i)), true) == 0;
+            }
+            bc.items = 4;
+        });
+    } });
+    cases.push_back({ "log/flood", [&] {
+        size_t lines = 100000 * (size_t)scale;
+        return RunBenchCase("log/flood", iterations, [&] { fs.RemoveAll(scratch / L"logs"); }, [&](BenchCase& bc) {
+            LogPipeline pipeline;
+            pipeline.Attach(nullptr, nullptr, scratch / L"logs");
+            std::atomic<unsigned long long> bytes{0};
+            ParallelFor(lines, 0, [&](size_t i) {
+                std::wstring line = L" Copying rbx-storage\\" + std::to_wstring(i % 256) + L"\\blob" + std::to_wstring(i);
+                bytes += line.size();
+                pipeline.Push(line);
+            });
+            pipeline.Shutdown();
+            bc.items = lines;
+            bc.bytes = bytes;
+        });
+    } });
+    cases.push_back({ "process/stream_lines", [&] {
+        int lines = 2000 * scale;
+        return RunBenchCase("process/stream_lines", iterations, nullptr, [&](BenchCase& bc) {
+            ProcessSpec spec;
+            spec.app = SystemToolPath(L"cmd.exe");
+            spec.args = L"/d /c for /l %i in (1,1," + std::to_wstring(lines) + L") do @echo Verifying %i";
+            spec.onLine = [&](const std::wstring& line) {
+                ++bc.items;
+                bc.bytes += line.size();
+            };
+            bc.matches = DefaultProcessRunner().Run(spec).exitCode == 0;
+        });
+    } });
+    cases.push_back({ "process/first_line", [&] {
+        return RunBenchCase("process/first_line", iterations, nullptr, [&](BenchCase& bc) {
+            std::atomic<bool> seen{false};
+            ProcessSpec spec;
+            spec.app = SystemToolPath(L"cmd.exe");
+            spec.args = L"/d /c echo ready& ping -n 4 127.0.0.1 >nul";
+            spec.cancel = &seen;
+            spec.onLine = [&](const std::wstring&) { seen = true; };
+            bc.matches = DefaultProcessRunner().Run(spec).cancelled;
+            bc.items = 1;
+        });
+    } });
+    std::vector<HANDLE> spawned;
+    auto reapSpawned = [&] {
+        for (HANDLE h : spawned) {
+            TerminateProcess(h, 1);
+            WaitForSingleObject(h, 5000);
+            CloseHandle(h);
+        }
+        spawned.clear();
+    };
+    cases.push_back({ "process/stop_tree", [&] {
+        std::set<DWORD> pids;
+        BenchCase bc = RunBenchCase("process/stop_tree", iterations, [&] {
+            reapSpawned();
+            pids.clear();
+            for (int i = 0; i < 8; ++i) {
+                std::wstring cmd = L"\"" + SystemToolPath(L"cmd.exe") + L"\" /d /c ping -n 30 127.0.0.1 >nul";
+                STARTUPINFOW si{};
+                si.cb = sizeof(si);
+                PROCESS_INFORMATION pi{};
+                if (!CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) continue;
+                CloseHandle(pi.hThread);
+                spawned.push_back(pi.hProcess);
+                pids.insert(pi.dwProcessId);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        }, [&](BenchCase& bc) {
+            StopProcessesReport r = StopProcesses(DefaultProcessControl(), [&](const ProcessInfo& p) {
+                return pids.count(p.pid) != 0;
+            }, 0, 5000);
+            bc.items = r.matched + r.children;
+            bc.matches = r.terminated;
+        });
+        reapSpawned();
+        return bc;
+    } });
+    cases.push_back({ "watch/create_latency", [&] {
+        std::filesystem::path dir = scratch / L"watch";
+        fs.RemoveAll(dir);
+        fs.CreateDirectories(dir);
+        DirectoryWatcher watcher(dir.wstring());
+        int round = 0;
+        return RunBenchCase("watch/create_latency", iterations, nullptr, [&](BenchCase& bc) {
+            for (int i = 0; i < 32; ++i) {
+                std::wstring name = L"RobloxPlayerInstaller-" + std::to_wstring(round++) + L".exe";
+                fs.WriteTextAtomic(dir / name, "MZ");
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+                bool found = false;
+                while (!found && std::chrono::steady_clock::now() < deadline) {
+                    std::vector<std::pair<DWORD, std::wstring>> changes;
+                    bool rescan = false;
+                    watcher.Wait(200, changes, rescan);
+                    for (const auto& c : changes) found = found || CaseInsensitiveEquals(c.second, name);
+                    found = found || rescan;
+                }
+                bc.matches += found;
+            }
+            bc.items = 32;
+        });
+    } });
+
+    std::string narrow(filter.begin(), filter.end());
+    int ran = 0;
+    for (auto& [name, run] : cases) {
+        if (!narrow.empty() && name.find(narrow) == std::string::npos) continue;
+        json.Write(BenchCaseJson(run()));
+        ++ran;
+    }
+    fs.RemoveAll(root);
+    if (!ran) {
+        json.Write("{\"event\":\"error\",\"message\":\"No benchmark matches " + JsonEscape(filter) + "\"}");
+        return 2;
+    }
+    return 0;
+}
+
+struct SelfTest {
+    std::string name;
+    std::vector<std::wstring> failures;
+
+    void Check(bool ok, const std::wstring& what) {
+        if (!ok) failures.push_back(what);
+    }
+};
+
+// Runs the fix helpers against a MemoryFileSystem rooted at a fake LocalAppData.
+// GetBackupRoot() still creates its folder on disk, so the fake root sits under
+// the real temp folder and is removed afterwards.
+class SelfTestEnvironment {
+public:
+    explicit SelfTestEnvironment(MemoryFileSystem& fs) : previous_(ActiveFixPaths()) {
+        root_ = std::filesystem::path(previous_.temp) / (L"ZenithFixerSelfTest-" + std::to_wstring(GetCurrentProcessId()));
+        FixPaths p;
+        p.localAppData = root_ / L"Local";
+        p.temp = p.localAppData / L"Temp";
+        p.backupRoot = p.temp / L"ZenithFixerBackup";
+        p.programFilesVersions = root_ / L"Program Files (x86)" / L"Roblox" / L"Versions";
+        SetFixPaths(p);
+        SetDefaultFileSystem(&fs);
+    }
+
+    ~SelfTestEnvironment() {
+        DefaultBackgroundDeleter().Wait();
+        SetDefaultFileSystem(nullptr);
+        SetFixPaths(previous_);
+        std::error_code ec;
+        std::filesystem::remove_all(root_, ec);
+    }
+
+    std::filesystem::path Local() const { return ActiveFixPaths().localAppData; }
+    std::filesystem::path Roblox() const { return Local() / L"Roblox"; }
+
+private:
+    FixPaths previous_;
+    std::filesystem::path root_;
+};
+
+static std::map<std::wstring, std::string> SelfTestFiles() {
+    std::map<std::wstring, std::string> files;
+    files[L"LocalStorage\\appStorage.json"] = "{\"volume\":0.5}";
+    files[L"LocalStorage\\robloxcookies.dat"] = std::string(70000, 'c');
+    for (int i = 0; i < 24; ++i) {
+        std::string blob(1000 + i * 997, (char)('a' + i % 26));
+        files[L"rbx-storage\\" + std::to_wstring(i % 4) + L"\\blob" + std::to_wstring(i)] = blob;
+    }
+    files[L"rbx-storage\\empty"] = std::string();
+    return files;
+}
+
+static void SelfTestSeed(MemoryFileSystem& fs, const std::filesystem::path& roblox, const std::map<std::wstring, std::string>& files) {
+    for (const auto& [rel, data] : files) fs.AddFile(roblox / rel, data, 1000);
+}
+
+static void SelfTestCompare(SelfTest& t, MemoryFileSystem& fs, const std::filesystem::path& roblox,
+                            const std::map<std::wstring, std::string>& files, const std::wstring& skip = std::wstring()) {
+    for (const auto& [rel, data] : files) {
+        std::string got;
+        bool present = fs.ReadText(roblox / rel, got);
+        if (!skip.empty() && rel == skip) {
+            t.Check(!present, L"unexpectedly restored " + rel);
+            continue;
+        }
+        t.Check(present, L"missing after restore: " + rel);
+        t.Check(!present || got == data, L"contents differ after restore: " + rel);
+    }
+}
+
+static void SelfTestBackupDeleteRestore(SelfTest& t) {
+    MemoryFileSystem fs;
+    fs.SetLatency(std::chrono::microseconds(20));
+    SelfTestEnvironment env(fs);
+    std::map<std::wstring, std::string> files = SelfTestFiles();
+    SelfTestSeed(fs, env.Roblox(), files);
+    fs.AddFile(env.Local() / L"bloxstrap" / L"Settings.json", "{}");
+
+    BackupRobloxData(nullptr);
+    DeleteAppDataDirs(nullptr, false);
+    for (const auto& r : DefaultBackgroundDeleter().Wait()) t.Check(r.failed == 0, L"background delete failed: " + r.label);
+    t.Check(!fs.Exists(env.Roblox()), L"Roblox folder survived the delete");
+    t.Check(!fs.Exists(env.Local() / L"bloxstrap"), L"bloxstrap folder survived the delete");
+
+    RestoreRobloxData(nullptr);
+    SelfTestCompare(t, fs, env.Roblox(), files);
+}
+
+static void SelfTestBackupReadFault(SelfTest& t) {
+    MemoryFileSystem fs;
+    SelfTestEnvironment env(fs);
+    std::map<std::wstring, std::string> files = SelfTestFiles();
+    SelfTestSeed(fs, env.Roblox(), files);
+    fs.AddFault({ L"read", L"blob7", ERROR_SHARING_VIOLATION });
+
+    BackupRobloxData(nullptr);
+    fs.ClearFaults();
+    DeleteAppDataDirs(nullptr, false);
+    DefaultBackgroundDeleter().Wait();
+    RestoreRobloxData(nullptr);
+    SelfTestCompare(t, fs, env.Roblox(), files, L"rbx-storage\\3\\blob7");
+}
+
+static void SelfTestDeleteFault(SelfTest& t) {
+    MemoryFileSystem fs;
+    SelfTestEnvironment env(fs);
+    std::map<std::wstring, std::string> files = SelfTestFiles();
+    SelfTestSeed(fs, env.Roblox(), files);
+    fs.AddFault({ L"delete", L"robloxcookies", ERROR_SHARING_VIOLATION });
+
+    DeleteReport r = DeleteTree(fs, env.Roblox(), L"Roblox");
+    t.Check(r.failed == 1, L"expected exactly one failed delete, got " + std::to_wstring(r.failed));
+    t.Check(r.files == files.size() - 1, L"expected every other file to be deleted");
+    t.Check(fs.Exists(env.Roblox() / L"LocalStorage" / L"robloxcookies.dat"), L"locked file was removed");
+    t.Check(!fs.Exists(env.Roblox() / L"rbx-storage"), L"rbx-storage survived the delete");
+}
+
+static void SelfTestHardLinks(SelfTest& t) {
+    MemoryFileSystem fs;
+    std::filesystem::path a = L"C:\\v\\version-a\\RobloxPlayerBeta.dll";
+    std::filesystem::path b = L"C:\\v\\version-b\\RobloxPlayerBeta.dll";
+    fs.AddFile(a, std::string(4096, 'x'));
+    t.Check(fs.LinkCount(a) == 1, L"a new file should have one link");
+    t.Check(fs.HardLink(a, b), L"HardLink failed");
+    t.Check(fs.LinkCount(a) == 2 && fs.LinkCount(b) == 2, L"linked files should report two links");
+    t.Check(fs.AppendText(b, "y"), L"append through the link failed");
+    std::string data;
+    t.Check(fs.ReadText(a, data) && data.size() == 4097, L"a write through one link should be visible through the other");
+    t.Check(fs.WriteTextAtomic(b, "replaced"), L"atomic replace of the link failed");
+    t.Check(fs.LinkCount(a) == 1 && fs.LinkCount(b) == 1, L"replacing a link should detach it");
+    t.Check(fs.HardLink(a, L"C:\\v\\version-c\\RobloxPlayerBeta.dll"), L"second HardLink failed");
+    fs.RemoveAll(L"C:\\v\\version-a");
+    t.Check(fs.LinkCount(L"C:\\v\\version-c\\RobloxPlayerBeta.dll") == 1, L"removing a link should drop the count");
+    t.Check(fs.Rename(L"C:\\v\\version-c", L"C:\\v\\version-d") && fs.LinkCount(L"C:\\v\\version-d\\RobloxPlayerBeta.dll") == 1,
+            L"renaming a folder should keep link counts");
+}
+
+static void SelfTestArchiveIncremental(SelfTest& t) {
+    MemoryFileSystem fs;
+    std::filesystem::path src = L"C:\\src", store = L"C:\\backup";
+    std::map<std::wstring, std::string> files;
+    for (int i = 0; i < 40; ++i) files[L"f" + std::to_wstring(100 + i)] = std::string(90000 + i, (char)('a' + i % 26));
+    files[L"big"] = std::string(3 * BackupArchive::kBlockSize + 17, 'z');
+    SelfTestSeed(fs, src, files);
+
+    ArchiveReport first = BackupArchive(fs, store).Backup(L"set", src);
+    t.Check(first.failed == 0 && first.files == files.size(), L"first backup should archive every file");
+    ArchiveReport again = BackupArchive(fs, store).Backup(L"set", src);
+    t.Check(again.reused == files.size(), L"an unchanged tree should reuse every file, reused " + std::to_wstring(again.reused));
+    t.Check(again.readBytes == 0, L"an unchanged tree should not be read again");
+
+    files[L"f120"] = "changed";
+    fs.AddFile(src / L"f120", files[L"f120"], 2000);
+    ArchiveReport changed = BackupArchive(fs, store).Backup(L"set", src);
+    t.Check(changed.failed == 0, L"backup after a change failed");
+    t.Check(changed.reused > 0 && changed.reused < files.size(), L"only the changed file's blocks should be packed again");
+    t.Check(changed.readBytes < first.readBytes / 4, L"backup after a change read " + FormatBytes(changed.readBytes));
+
+    ArchiveReport restored = BackupArchive(fs, store).Restore(L"set", L"C:\\out");
+    t.Check(restored.failed == 0 && restored.extracted == files.size(), L"restore after an incremental backup failed");
+    SelfTestCompare(t, fs, L"C:\\out", files);
+}
+
+static void SelfTestArchiveCarryForward(SelfTest& t) {
+    MemoryFileSystem fs;
+    std::filesystem::path src = L"C:\\src", store = L"C:\\backup";
+    std::map<std::wstring, std::string> files = SelfTestFiles();
+    SelfTestSeed(fs, src, files);
+    BackupArchive(fs, store).Backup(L"set", src);
+
+    fs.RemoveAll(src / L"rbx-storage" / L"2");
+    fs.AddFault({ L"read", L"blob5", ERROR_SHARING_VIOLATION });
+    files[L"LocalStorage\\appStorage.json"] = "{\"volume\":1}";
+    fs.AddFile(src / L"LocalStorage" / L"appStorage.json", files[L"LocalStorage\\appStorage.json"], 3000);
+    ArchiveReport r = BackupArchive(fs, store).Backup(L"set", src);
+    t.Check(r.carried == 6, L"files removed from the source should be carried forward, carried " + std::to_wstring(r.carried));
+    t.Check(r.failed == 1, L"the unreadable file should be reported");
+    fs.ClearFaults();
+
+    BackupArchive(fs, store).Restore(L"set", L"C:\\out");
+    SelfTestCompare(t, fs, L"C:\\out", files);
+}
+
+static void SelfTestSnapshotMigration(SelfTest& t) {
+    for (bool corrupt : { false, true }) {
+        MemoryFileSystem fs;
+        SelfTestEnvironment env(fs);
+        std::filesystem::path backupRoot = GetBackupRoot();
+        std::map<std::wstring, std::string> files = SelfTestFiles();
+        std::string manifest = "zfsnap1\n";
+        for (const auto& [rel, data] : files) {
+            std::wstring set = rel.substr(0, rel.find(L'\\'));
+            if (set != L"rbx-storage") continue;
+            Sha256 sha;
+            sha.Update(data.data(), data.size());
+            std::wstring hash = sha.FinishHex();
+            fs.AddFile(backupRoot / L"Blobs" / hash.substr(0, 2) / hash, corrupt && rel.find(L"blob3") != std::wstring::npos ? "bad" : data);
+            manifest += "F\t" + ToUtf8(rel.substr(set.size() + 1)) + "\t" + std::to_string(data.size()) + "\t1000\t" + ToUtf8(hash) + "\n";
+        }
+        fs.AddFile(backupRoot / L"Snapshots" / L"rbx-storage.manifest", manifest);
+        std::map<std::wstring, std::string> live = { { L"LocalStorage\\appStorage.json", "{}" }, { L"rbx-storage\\0\\blob0", "" } };
+        SelfTestSeed(fs, env.Roblox(), live);
+
+        BackupRobloxData(nullptr);
+        t.Check(fs.Exists(backupRoot / L"Snapshots") == corrupt,
+                corrupt ? L"a snapshot that failed to migrate was removed" : L"a migrated snapshot was left behind");
+        DeleteAppDataDirs(nullptr, false);
+        DefaultBackgroundDeleter().Wait();
+        RestoreRobloxData(nullptr);
+        for (auto it = files.begin(); it != files.end();) {
+            if (it->first.compare(0, 12, L"LocalStorage") == 0) it = files.erase(it);
+            else ++it;
+        }
+        for (const auto& [rel, data] : live) files[rel] = data;
+        SelfTestCompare(t, fs, env.Roblox(), files, corrupt ? L"rbx-storage\\3\\blob3" : std::wstring());
+    }
+}
+
+static void SelfTestPruneVersions(SelfTest& t) {
+    for (bool installerStarted : { false, true }) {
+        MemoryFileSystem fs;
+        SelfTestEnvironment env(fs);
+        std::filesystem::path versions = env.Roblox() / L"Versions";
+        fs.AddFile(versions / L"version-live" / L"RobloxPlayerBeta.exe", "live");
+        fs.AddFile(versions / L"version-old" / L"RobloxPlayerBeta.exe", "old");
+        fs.AddFile(versions / L"version-studio" / L"RobloxStudioBeta.exe", "studio");
+        fs.AddFile(versions / L"version-studio" / L"RobloxPlayerBeta.exe", "studio player");
+        fs.AddFile(versions / L"version-partial" / L"content" / L"sounds.zip", "partial");
+
+        PruneRobloxVersions(nullptr, L"version-live", installerStarted);
+        DefaultBackgroundDeleter().Wait();
+        t.Check(fs.Exists(versions / L"version-live"), L"the live version was pruned");
+        t.Check(fs.Exists(versions / L"version-studio"), L"a Studio version was pruned");
+        t.Check(fs.Exists(versions / L"version-partial"), L"a folder without RobloxPlayerBeta.exe was pruned");
+        t.Check(fs.Exists(versions / L"version-old") == installerStarted,
+                installerStarted ? L"pruned while the installer from this run may still be running" : L"the stale player version was kept");
+    }
+}
+
+static void SelfTestNameMatcherOverflow(SelfTest& t) {
+    std::vector<std::wstring> patterns;
+    for (int i = 0; i < 40; ++i) patterns.push_back(L"tool" + std::to_wstring(i) + L".exe");
+    NameMatcher matcher(patterns);
+    t.Check(matcher.Match(L"TOOL3.EXE") == 1u << 3, L"Match should report the bit of an indexed pattern");
+    t.Check(matcher.Any(L"c:\\bin\\tool39.exe"), L"a pattern past the 32nd was ignored by Any");
+    t.Check(matcher.Match(L"tool39.exe") == 0, L"patterns past the 32nd have no Match bit");
+    t.Check(!matcher.Any(L"tool40.exe"), L"Any matched a name that is not in the set");
+}
+
+static void SelfTestResetWebViewData(SelfTest& t) {
+    MemoryFileSystem fs;
+    SelfTestEnvironment env(fs);
+    std::filesystem::path dir = env.Local() / L"zenith.soft" / L"EBWebView";
+    fs.AddFile(dir / L"Local State", "{}");
+    fs.AddFile(dir / L"Default" / L"Cookies", std::string(4096, 'c'));
+    fs.AddFile(dir / L"Default" / L"Cache" / L"data_0", std::string(8192, 'd'));
+    fs.AddFault({ L"delete", L"Cookies", ERROR_ACCESS_DENIED });
+
+    std::vector<bool> grants;
+    bool ok = ResetDataDirectory(fs, dir, L"EBWebView", nullptr, [&](bool resetChildren, size_t&) -> DWORD {
+        grants.push_back(resetChildren);
+        if (resetChildren) fs.ClearFaults();
+        return ERROR_SUCCESS;
+    });
+    t.Check(ok, L"reset reported failure");
+    t.Check(grants == std::vector<bool>{ false, true }, L"expected one top-level grant and one tree reset after the locked delete");
+    t.Check(fs.Exists(dir), L"data directory was not recreated");
+    t.Check(fs.List(dir).empty(), L"data directory should be empty after the reset");
+}
+
+// Minimal HTTP/1.1 server on 127.0.0.1 for exercising DownloadWithHttp. It
+// serves one body with an ETag, honours single Range requests, and can cut GET
+// responses short to simulate dropped connections.
+class LoopbackHttpServer {
+public:
+    LoopbackHttpServer(std::string body, std::string etag) : body_(std::move(body)), etag_(std::move(etag)) {
+        WSADATA wsa;
+        started_ = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+        listener_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int len = sizeof(addr);
+        if (listener_ == INVALID_SOCKET || bind(listener_, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(listener_, 16) != 0 || getsockname(listener_, (sockaddr*)&addr, &len) != 0) {
+            return;
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this]() { Serve(); });
+    }
+
+    ~LoopbackHttpServer() {
+        if (listener_ != INVALID_SOCKET) closesocket(listener_);
+        if (thread_.joinable()) thread_.join();
+        for (auto& t : clients_) t.join();
+        if (started_) WSACleanup();
+    }
+
+    bool Listening() const { return port_ != 0; }
+
+    std::wstring Url() const { return L"http://127.0.0.1:" + std::to_wstring(port_) + L"/RobloxPlayerInstaller.exe"; }
+
+    void TruncateNextGets(int count) { truncate_ = count; }
+
+    std::vector<unsigned long long> RangeStarts() {
+        std::lock_guard<std::mutex> g(m_);
+        std::vector<unsigned long long> starts = starts_;
+        std::sort(starts.begin(), starts.end());
+        return starts;
+    }
+
+private:
+    void Serve() {
+        for (;;) {
+            SOCKET s = accept(listener_, nullptr, nullptr);
+            if (s == INVALID_SOCKET) return;
+            clients_.emplace_back([this, s]() {
+                Handle(s);
+                shutdown(s, SD_BOTH);
+                closesocket(s);
+            });
+        }
+    }
+
+    void Handle(SOCKET s) {
+        std::string req;
+        char buf[4096];
+        while (req.find("\r\n\r\n") == std::string::npos) {
+            int n = recv(s, buf, sizeof(buf), 0);
+            if (n <= 0) return;
+            req.append(buf, n);
+        }
+        std::string lower = req;
+        for (auto& c : lower) c = (char)tolower((unsigned char)c);
+        bool head = req.compare(0, 5, "HEAD ") == 0;
+        unsigned long long first = 0, last = body_.size() - 1;
+        size_t range = lower.find("\r\nrange: bytes=");
+        size_t ifRange = lower.find("\r\nif-range: ");
+        bool ranged = range != std::string::npos &&
+                      (ifRange == std::string::npos || req.compare(ifRange + 12, etag_.size(), etag_) == 0);
+        if (ranged) {
+            const char* p = req.c_str() + range + 15;
+            char* end = nullptr;
+            first = std::strtoull(p, &end, 10);
+            if (*end == '-' && isdigit((unsigned char)end[1])) last = (std::min)(last, (unsigned long long)std::strtoull(end + 1, nullptr, 10));
+        }
+        std::string out = std::string("HTTP/1.1 ") + (ranged ? "206 Partial Content" : "200 OK") + "\r\n";
+        out += "Content-Length: " + std::to_string(last - first + 1) + "\r\n";
+        if (ranged) out += "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(body_.size()) + "\r\n";
+        out += "Accept-Ranges: bytes\r\nETag: " + etag_ + "\r\nLast-Modified: Sat, 17 Oct 2026 00:00:00 GMT\r\nConnection: close\r\n\r\n";
+        size_t length = (size_t)(last - first + 1);
+        if (!head) {
+            std::lock_guard<std::mutex> g(m_);
+            starts_.push_back(first);
+            if (truncate_ > 0) {
+                --truncate_;
+                length /= 2;
+            }
+            out.append(body_, (size_t)first, length);
+        } else {
+            length = 0;
+        }
+        for (size_t sent = 0; sent < out.size();) {
+            int n = send(s, out.data() + sent, (int)(std::min)(out.size() - sent, (size_t)1 << 20), 0);
+            if (n <= 0) return;
+            sent += (size_t)n;
+        }
+    }
+
+    std::string body_;
+    std::string etag_;
+    bool started_{false};
+    SOCKET listener_{INVALID_SOCKET};
+    unsigned short port_{0};
+    std::thread thread_;
+    std::vector<std::thread> clients_;
+    std::mutex m_;
+    int truncate_{0};
+    std::vector<unsigned long long> starts_;
+};
+
+static std::string SelfTestDownloadBody() {
+    std::string body(12 * 1024 * 1024, '\0');
+    unsigned long long x = 0x9E3779B97F4A7C15ull;
+    for (auto& c : body) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        c = (char)(x >> 56);
+    }
+    return body;
+}
+
+static bool SelfTestReadFile(const std::filesystem::path& p, std::string& data) {
+    std::ifstream in(p, std::ios::binary);
+    if (!in) return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static void SelfTestDownloadRetry(SelfTest& t) {
+    std::string body = SelfTestDownloadBody();
+    LoopbackHttpServer server(body, "\"zf-selftest\"");
+    if (!server.Listening()) {
+        t.Check(false, L"could not listen on 127.0.0.1");
+        return;
+    }
+    std::filesystem::path dir = std::filesystem::path(GetLocalTemp()) / (L"ZenithFixerSelfTest-http-" + std::to_wstring(GetCurrentProcessId()));
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    server.TruncateNextGets(3);
+    WinHttpTransport http;
+    bool ok = DownloadWithHttp(http, server.Url(), dir / L"installer.exe", nullptr, nullptr);
+    std::string got;
+    t.Check(ok, L"download failed after dropped connections");
+    t.Check(SelfTestReadFile(dir / L"installer.exe", got) && got == body, L"downloaded bytes differ from the served body");
+    std::vector<unsigned long long> starts = server.RangeStarts();
+    size_t resumed = (size_t)std::count_if(starts.begin(), starts.end(), [](unsigned long long s) { return s % (4 * 1024 * 1024) != 0; });
+    t.Check(starts.size() == 6 && resumed == 3, L"each cut-short chunk should be resumed once with a Range request");
+    std::filesystem::remove_all(dir, ec);
+}
+
+static void SelfTestDownloadResume(SelfTest& t) {
+    const unsigned long long kMiB = 1024 * 1024;
+    std::string body = SelfTestDownloadBody();
+    for (bool stale : { false, true }) {
+        LoopbackHttpServer server(body, "\"zf-selftest\"");
+        if (!server.Listening()) {
+            t.Check(false, L"could not listen on 127.0.0.1");
+            return;
+        }
+        std::filesystem::path dir = std::filesystem::path(GetLocalTemp()) / (L"ZenithFixerSelfTest-http-" + std::to_wstring(GetCurrentProcessId()));
+        std::filesystem::path dest = dir / L"installer.exe";
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        {
+            std::string part(body.size(), '\0');
+            std::copy(body.begin(), body.begin() + kMiB, part.begin());
+            std::copy(body.begin() + 4 * kMiB, body.begin() + 6 * kMiB, part.begin() + 4 * kMiB);
+            std::ofstream out(dir / L"installer.exe.part", std::ios::binary | std::ios::trunc);
+            out.write(part.data(), (std::streamsize)part.size());
+        }
+        HttpResponse info;
+        info.totalSize = body.size();
+        info.hasTotalSize = true;
+        info.etag = stale ? L"\"zf-old\"" : L"\"zf-selftest\"";
+        info.lastModified = L"Sat, 17 Oct 2026 00:00:00 GMT";
+        SaveDownloadState(dir / L"installer.exe.part.meta", info,
+                          { { 0, 4 * kMiB, kMiB }, { 4 * kMiB, 8 * kMiB, 2 * kMiB }, { 8 * kMiB, 12 * kMiB, 0 } });
+
+        WinHttpTransport http;
+        bool ok = DownloadWithHttp(http, server.Url(), dest, nullptr, nullptr);
+        std::string got;
+        t.Check(ok, stale ? L"download with a stale partial file failed" : L"resumed download failed");
+        t.Check(SelfTestReadFile(dest, got) && got == body, L"downloaded bytes differ from the served body");
+        std::vector<unsigned long long> expected = stale ? std::vector<unsigned long long>{ 0, 4 * kMiB, 8 * kMiB }
+                                                         : std::vector<unsigned long long>{ kMiB, 6 * kMiB, 8 * kMiB };
+        t.Check(server.RangeStarts() == expected,
+                stale ? L"a partial file for another ETag should be discarded" : L"the download should resume where each chunk stopped");
+        t.Check(!std::filesystem::exists(dir / L"installer.exe.part.meta", ec), L"resume state left behind after success");
+        std::filesystem::remove_all(dir, ec);
+    }
+}
+
+static int RunSelfTests(JsonLineWriter& json, const std::wstring& filter) {
+    std::vector<std::pair<std::string, std::function<void(SelfTest&)>>> tests = {
+        { "fs/hard_links", SelfTestHardLinks },
+        { "fs/delete_fault", SelfTestDeleteFault },
+        { "backup/delete_restore", SelfTestBackupDeleteRestore },
+        { "backup/read_fault", SelfTestBackupReadFault },
+        { "archive/incremental", SelfTestArchiveIncremental },
+        { "archive/carry_forward", SelfTestArchiveCarryForward },
+        { "archive/snapshot_migration", SelfTestSnapshotMigration },
+        { "versions/prune", SelfTestPruneVersions },
+        { "match/name_matcher_overflow", SelfTestNameMatcherOverflow },
+        { "webview/reset_data_dir", SelfTestResetWebViewData },
+        { "http/retry_ranges", SelfTestDownloadRetry },
+        { "http/resume", SelfTestDownloadResume },
+    };
+    std::string narrow(filter.begin(), filter.end());
+    int ran = 0, failed = 0;
+    for (auto& [name, run] : tests) {
+        if (!narrow.empty() && name.find(narrow) == std::string::npos) continue;
+        SelfTest t;
+        t.name = name;
+        auto start = std::chrono::steady_clock::now();
+        run(t);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::string line = "{\"event\":\"test\",\"name\":\"" + name + "\",\"ok\":" + (t.failures.empty() ? "true" : "false") +
+                           ",\"ms\":" + std::to_string(ms) + ",\"failures\":[";
+        for (size_t i = 0; i < t.failures.size(); ++i) line += (i ? ",\"" : "\"") + JsonEscape(t.failures[i]) + "\"";
+        json.Write(line + "]}");
+        ++ran;
+        failed += !t.failures.empty();
+    }
+    if (!ran) {
+        json.Write("{\"event\":\"error\",\"message\":\"No self-test matches " + JsonEscape(filter) + "\"}");
+        return 2;
+    }
+    json.Write("{\"event\":\"selftest\",\"ran\":" + std::to_string(ran) + ",\"failed\":" + std::to_string(failed) + "}");
+    return failed ? 1 : 0;
+}
+
+static std::string StepPlanJson(const std::vector<FixStep>& steps) {
+    std::string json = "{\"event\":\"plan\",\"steps\":[";
+    bool first = true;
+    for (size_t i : PlanStepOrder(steps)) {
+        const FixStep& st = steps[i];
+        json += (first ? "" : ",");
+        json += "{\"id\":\"" + JsonEscape(st.id) + "\",\"title\":\"" + JsonEscape(st.title) + "\",\"dependsOn\":[";
+        for (size_t d = 0; d < st.dependsOn.size(); ++d) json += (d ? ",\"" : "\"") + JsonEscape(st.dependsOn[d]) + "\"";
+        json += "]}";
+        first = false;
+    }
+    return json + "]}";
+}
+
+static int RunCli(int argc, wchar_t** argv) {
+    JsonLineWriter json(OpenCliStdout());
+    CliOptions opts;
+    std::wstring error;
+    if (!ParseCliOptions(argc, argv, opts, error)) {
+        json.Write("{\"event\":\"error\",\"message\":\"" + JsonEscape(error) + "\"}");
+        return 2;
+    }
+    if (opts.help) {
+        json.Write("{\"event\":\"help\",\"text\":\"" + JsonEscape(
+            L"usage: zenithfixer [--steps=id,id,...] [--dns=yes|no] [--yes] [--dry-run] [--list-steps] [--resume] [--bench] [--selftest]\n"
+            L"Runs the selected fix steps without the GUI and prints one JSON event per line.\n"
+            L"--yes is required to make changes; --dry-run prints the plan only.\n"
+            L"--list-steps prints the plan after applying --steps and --resume.\n"
+            L"--resume continues an interrupted run, skipping steps that already finished.\n"
+            L"--bench[=filter] [--bench-scale=N] [--bench-iterations=N] times scanning, matching, backup,\n"
+            L"archive, restore, copy, delete, log flooding, PowerShell, child processes and directory\n"
+            L"watching over a synthetic tree in %TEMP% and prints one JSON result per case.\n"
+            L"--selftest[=filter] runs backup, delete, restore and prune against an in-memory file system and ranged downloads\n"
+            L"against a loopback HTTP server, and exits nonzero on failure.") + "\"}");
+        return 0;
+    }
+    if (opts.bench) return RunBenchmarks(json, opts.benchFilter, opts.benchScale, opts.benchIterations);
+    if (opts.selfTest) return RunSelfTests(json, opts.selfTestFilter);
+
+    RunJournalState previous;
+    if (opts.resume) {
+        previous = DefaultRunJournal().Load();
+        if (previous.incomplete) {
+            opts.changeDns = previous.changeDns;
+            opts.steps = previous.selection;
+        } else {
+            json.Write("{\"event\":\"warning\",\"message\":\"No interrupted run to resume; starting a new run.\"}");
+        }
+    }
+    bool resume = opts.resume && previous.incomplete;
+
+    auto run = std::make_shared<FixRunState>();
+    std::vector<FixStep> steps = BuildFixSteps(nullptr, run, opts.changeDns);
+    if (!SelectSteps(steps, opts.steps, error)) {
+        json.Write("{\"event\":\"error\",\"message\":\"" + JsonEscape(error) + "\"}");
+        return 2;
+    }
+    if (resume) {
+        RestoreRunState(*run, previous);
+        size_t skipped = SkipFinishedSteps(steps, previous.finished);
+        json.Write("{\"event\":\"resume\",\"skipped\":" + std::to_string(skipped) + "}");
+    }
+    json.Write(StepPlanJson(steps));
+    if (opts.listSteps) return 0;
+    if (opts.dryRun) {
+        json.Write("{\"event\":\"done\",\"ok\":true,\"dryRun\":true}");
+        return 0;
+    }
+    if (!opts.yes) {
+        json.Write("{\"event\":\"error\",\"message\":\"Refusing to make changes without --yes.\"}");
+        return 2;
+    }
+    if (!IsProcessElevated()) {
+        json.Write("{\"event\":\"warning\",\"message\":\"Not running elevated; system steps will fail.\"}");
+    }
+
+    Logs().SetSink([&json](const LogRecord& r) {
+        json.Write("{\"event\":\"log\",\"text\":\"" + JsonEscape(r.text) + "\"}");
+    });
+    Logs().Attach(nullptr, nullptr, GetBackupRoot() / L"logs");
+
+    StepGraphObserver observer;
+    observer.progress = [&json](int pct) { json.Write("{\"event\":\"progress\",\"percent\":" + std::to_string(pct) + "}"); };
+    observer.started = [&json](const FixStep& st, size_t index, size_t total) {
+        json.Write("{\"event\":\"start\",\"step\":\"" + JsonEscape(st.id) + "\",\"index\":" + std::to_string(index) +
+                   ",\"total\":" + std::to_string(total) + "}");
+    };
+    observer.finished = [&json](const FixStep& st, bool ok, long long ms) {
+        json.Write("{\"event\":\"end\",\"step\":\"" + JsonEscape(st.id) + "\",\"ok\":" + (ok ? "true" : "false") +
+                   ",\"ms\":" + std::to_string(ms) + "}");
+    };
+
+    RunJournal& journal = DefaultRunJournal();
+    if (resume) journal.Resume();
+    else journal.Begin(opts.changeDns, opts.steps);
+
+    bool ok = false;
+    {
+        TraceScope trace(L"run", L"fix");
+        ok = RunStepGraph(WithJournal(observer, journal), nullptr, steps, DefaultStepWorkers());
+        for (const auto& r : DefaultBackgroundDeleter().Wait()) LogDeleteReport(nullptr, r);
+        journal.End(ok);
+    }
+    AppendLog(nullptr, DefaultArtifactCache().StatsLine());
+    WriteTraceReport(nullptr);
+    Logs().Shutdown();
+    json.Write(std::string("{\"event\":\"done\",\"ok\":") + (ok ? "true" : "false") + "}");
+    return ok ? 0 : 1;
+}
+
+int APIENTRY wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow) {
+    if (!GetEnv(L"ZENITHFIXER_TRACE").empty()) Tracer::Instance().Enable();
+
+    int argc = 0;
+    wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv && IsCliInvocation(argc, argv)) {
+        int code = RunCli(argc, argv);
+        LocalFree(argv);
+        return code;
+    }
+    if (argv) LocalFree(argv);
+
+    INITCOMMONCONTROLSEX iccex{};
+    iccex.dwSize = sizeof(iccex);
+    iccex.dwICC = ICC_PROGRESS_CLASS | ICC_LISTVIEW_CLASSES;
+    InitCommonControlsEx(&iccex);
+
+    const wchar_t* CLASS_NAME = L"ZenithFixerWinClass";
+    WNDCLASSW wc{};
+    wc.lpfnWndProc = WndProc;
+    wc.hInstance = hInst;
+    wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+    wc.lpszClassName = CLASS_NAME;
+    if (!RegisterClassW(&wc)) return 0;
+    HWND hwnd = CreateWindowExW(0, CLASS_NAME, L"Zenith Fixer",
+                                WS_OVERLAPPED | WS_CAPTION | WS_MINIMIZEBOX | WS_SYSMENU,
+                                CW_USEDEFAULT, CW_USEDEFAULT, 610, 450,
+                                nullptr, nullptr, hInst, nullptr);
+    if (!hwnd) return 0;
+    ShowWindow(hwnd, nCmdShow);
+    UpdateWindow(hwnd);
+    MSG msg{};
+    while (GetMessageW(&msg, nullptr, 0, 0)) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+    return (int)msg.wParam;
+
+}